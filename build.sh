@@ -14,6 +14,7 @@ fi
 
 PRJ_BASE_FILE="prj.conf.base"
 PRJ_FILE="prj.conf.$TARGET_ENV"
+PRJ_FOTA_FILE="prj.conf.fota"
 BUILD_DIR=build/$TARGET_BOARD/$TARGET_ENV/
 
 if [ ! -e "$PRJ_FILE" ]; then
@@ -23,5 +24,8 @@ fi
 
 mkdir -p $BUILD_DIR
 cat $PRJ_BASE_FILE $PRJ_FILE > prj.conf
+if [ "$FOTA" = "y" ]; then
+  cat $PRJ_FOTA_FILE >> prj.conf
+fi
 
 west build -b $TARGET_BOARD -d $BUILD_DIR --  -DSIPF_ENVIRONMENT=$TARGET_ENV
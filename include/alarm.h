@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//xv (Mf[^̖ɕt)
+enum alarm_cause {
+	ALARM_NONE = 0,  //M
+	ALARM_LEVEL = 1, //ʂl (lȉ)
+	ALARM_RISE = 2,  //ʏ㏸x
+};
+
+//x񔻒
+struct alarm_state {
+	int16_t last_mm;   //Ő
+	int64_t last_ms;   //O̔莞
+	int64_t sent_ms;   //Ǒx񑗐M
+	bool level_latched; //ʂlߒ (qXeVX߂܂ōČx񂵂Ȃ)
+};
+
+//xv𔻒 (distance_mm̏ꍇ͔肵Ȃ)
+enum alarm_cause alarm_evaluate(struct alarm_state *state, int16_t distance_mm, int64_t now_ms);
+
+#endif /* ALARM_H_ */
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef AT_PARSE_H_
+#define AT_PARSE_H_
+
+#include <stdbool.h>
+
+//AT%XMONITOR Mf[^p̍ (̂܂ܑM)
+struct xmonitor_info {
+	char plmn[8];     //PLMN ["44020"]
+	char tac[7];      //TACR[h ["185C"]
+	char band[3];     //ohԍ [18]
+	char cell_id[11]; //CELL ID ["008AAA5C"]
+};
+
+//AT%CONEVAL Mf[^p̍ (̂܂ܑM)
+struct coneval_info {
+	char es[2];   //d͌
+	char rsrp[4]; //MMd
+	char rsrq[4]; //MMi
+	char snr[4];  //MmCY
+};
+
+//AT%XMONITOR̉ (͕̂ߏBs̓G[lZbgfalse)
+bool at_parse_xmonitor(char *response, struct xmonitor_info *info);
+
+//AT%CONEVAL̉ (͕̂ߏBs̓G[lZbgfalse)
+bool at_parse_coneval(char *response, struct coneval_info *info);
+
+#endif /* AT_PARSE_H_ */
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef BATT_H_
+#define BATT_H_
+
+#include <stdint.h>
+
+#define BATT_SAMPLES 10 //ςADCTv
+
+//ADCTv(12bit ő3.6V)̕ςddmVɊZ (R߂)
+int16_t batt_mv(const int16_t *samples, int count);
+
+#endif /* BATT_H_ */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef DEFER_H_
+#define DEFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DEFER_COST_UNIT 10 //d͗ʂ̒P (GlM[l9̑M110Ƃ)
+#define DEFER_MAGIC 0x44460001
+
+//M茋
+enum defer_decision {
+	DEFER_SEND = 0,      //M (dg󋵗ǍD)
+	DEFER_HOLD = 1,      //M (Mf[^ɎcĎ̎ōĔ)
+	DEFER_SEND_URGENT,   //x̂ߓdg󋵂Ɋւ炸M
+	DEFER_SEND_DEADLINE, //EMf[^t̂ߓdg󋵂Ɋւ炸M
+};
+
+//M (ΏۊOϐɒuAZbgMf[^ƂƂɈp)
+struct defer_state {
+	uint32_t magic;
+	int64_t oldest_ms;     //ōłÂf[^̌v (0:Ȃ)
+	uint16_t pending;      //̃f[^
+	uint32_t pending_cost; //̃f[^̉_̐d͗ʂ̍v
+	uint32_t deferred;     //
+	uint32_t forced;       //Etœdg󋵂Ɋւ炸M
+	int32_t saved;         //ߖd͗ (_ƑM_̐d͗ʂ̍̍v)
+};
+
+//M1񂠂̐d͗ (AT%CONEVAL GlM[l 5`9Asȏꍇ9Ɠ)
+uint16_t defer_cost(int es);
+
+#if defined(CONFIG_UDP_DEFER_ENABLE)
+//Mԏ (queued: pMf[^)
+void defer_init(struct defer_state *state, int queued);
+
+//M (es: GlM[l rsrp_dbm: Md urgent: x queue_full: Mf[^t)
+enum defer_decision defer_evaluate(struct defer_state *state, int es, int rsrp_dbm, bool urgent, bool queue_full,
+                                   int64_t now_ms);
+
+//M (Ăf[^̐ߖʂWv)
+void defer_sent(struct defer_state *state, int es);
+#else
+static inline void defer_init(struct defer_state *state, int queued)
+{
+	*state = (struct defer_state){ .magic = DEFER_MAGIC };
+}
+static inline enum defer_decision defer_evaluate(struct defer_state *state, int es, int rsrp_dbm, bool urgent,
+                                                 bool queue_full, int64_t now_ms) { return DEFER_SEND; }
+static inline void defer_sent(struct defer_state *state, int es) {}
+#endif
+
+#endif /* DEFER_H_ */
@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef DTLS_H_
+#define DTLS_H_
+
+//DTLS (PSKfɏށBLTEڑOɌĂ)
+int dtls_init(void);
+
+//DTLS\Pbgݒ (connectOɌĂԁBconnectŃnhVFCNs)
+int dtls_socket_setup(int fd);
+
+#endif /* DTLS_H_ */
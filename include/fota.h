@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef FOTA_H_
+#define FOTA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//FOTA (ݒ̈̓ǂݍ)
+int fota_init(void);
+
+//NC[W̊m (񑗐MɌĂԁBm̂܂܍ċNMCUbootC[Wɖ߂)
+void fota_confirm_image(void);
+
+//_E[hr̃C[W (T[o̗vȂĂ̎őM)
+bool fota_in_progress(void);
+
+//FOTA (T[oFOTAv󂯂A܂̓_E[hr̎ɌĂ)
+//1̌ĂяoōőCONFIG_UDP_FOTA_CHUNKS_PER_CYCLE`NAbudget_msȓŎMAȂΑł؂
+//߂l 0:XVȂ/p 1:؊u[g҂ :G[
+int fota_process(const char *iccid, uint32_t budget_ms);
+
+#endif /* FOTA_H_ */
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PAYLOAD_H_
+#define PAYLOAD_H_
+
+//M̏ (src/main.c  tools/bench.c ŋ)
+//,ICCID,dd,x,x5,M,oh,PLMN,TAC,ZID,ES,RSRP,RSRQ,SNR,ZT[,gC,xv,
+//N񕜉x4,N,V[PXԍ
+#define PAYLOAD_FORMAT \
+	"%.20s,%.19s,%04d,%c%02d.%02d,%d,%d,%d,%d,%d,%010d,%.2s,%.7s,%.6s,%.10s,%.1s,%.3s,%.3s,%.3s,%1d,%02d,%1d,%u,%u,%u,%u,%u,%u"
+
+//ffp̗ (CONFIG_UDP_PAYLOAD_EXTENDED)
+//M,M,ߖd͗,␳̋
+#define PAYLOAD_FORMAT_EXTENDED ",%u,%u,%d,%d"
+
+#endif /* PAYLOAD_H_ */
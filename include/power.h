@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+//dǗΏۂ̎Ӌ@\̎
+enum power_domain {
+	POWER_UART, //UART0 (gZT[MER\[o)
+	POWER_I2C,  //I2C2 (xZT[)
+	POWER_ADC,  //ADC (drd)
+	POWER_DOMAIN_COUNT
+};
+
+//dǗ (SĂ̎Ӌ@\~Ԃɂ)
+int power_init(void);
+
+//Ӌ@\̗pJn (p01ɂȂɋN)
+int power_get(enum power_domain domain);
+
+//Ӌ@\̗pI (p0ɂȂɒ~)
+int power_put(enum power_domain domain);
+
+#endif /* POWER_H_ */
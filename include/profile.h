@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+//vEM̋
+enum profile_step {
+	PROFILE_CYCLE,          //vEMS
+	PROFILE_RANGE,          //gZT[v (ZT[҂Ԃ܂)
+	PROFILE_RANGE_PARSE,    //t[ϊ (1)
+	PROFILE_RANGE_CHECK,    //͈͔ (1t[)
+	PROFILE_AT_XMONITOR,    //AT%XMONITOR
+	PROFILE_PARSE_XMONITOR, //AT%XMONITOR
+	PROFILE_AT_CONEVAL,     //AT%CONEVAL
+	PROFILE_PARSE_CONEVAL,  //AT%CONEVAL
+	PROFILE_AT_INFO,        //AT+CCLK? / AT%XICCID
+	PROFILE_ADC,            //ddvEZ
+	PROFILE_TEMP,           //xv
+	PROFILE_FORMAT,         //M񐶐
+	PROFILE_SEND,           //UDPM
+	PROFILE_STEP_COUNT
+};
+
+#if defined(CONFIG_UDP_PROFILE_ENABLE)
+void profile_init(void);
+void profile_begin(enum profile_step step);
+void profile_end(enum profile_step step);
+void profile_report(void);
+#else
+static inline void profile_init(void) {}
+static inline void profile_begin(enum profile_step step) {}
+static inline void profile_end(enum profile_step step) {}
+static inline void profile_report(void) {}
+#endif
+
+#endif /* PROFILE_H_ */
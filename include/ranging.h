@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef RANGING_H_
+#define RANGING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RANGING_FRAME_COUNT 5 //̗pvl̐
+#define RANGING_ERROR -1      //vlG[
+#define RANGING_TIMEOUT -999  //ZT[Ȃ
+#define RANGING_MEDIAN_WINDOW_MM 60 //l炱̋ȏ㗣ꂽvl͕ς珜
+#define RANGING_TIMEOUT_FRAMES 10   //̎̊UARTMłȂ΃ZT[Ȃ
+
+#define RANGING_TEMP_REF_C16 (20 * 16)       //ZT[ZɎg̊x (1/16P)
+#define RANGING_TEMP_FACTOR_ONE (1UL << 16) //x␳W 1.0 (Q16)
+
+//gZT[@
+struct ranging_sensor {
+	const char *name;         //@햼
+	uint8_t unit_mm;          //o1JEgmm (mmo:1 cmo:10)
+	uint8_t range_code;       //Mf[^̃ZT[ (0:5m 1:10m)
+	uint8_t warmup_frames;    //Nɓǂݎ̂Ăt[
+	uint16_t frame_period_ms; //t[o͎
+	int16_t min_mm;           //L͈  (߂W̒lo͂邽߁A̒lȉ͖)
+	int16_t max_mm;           //L͈  (𒴂l͌os)
+	int16_t no_target;        //os̃ZT[o͒l
+	bool temp_compensated;    //ZT[ŉx␳ς
+};
+
+extern const struct ranging_sensor ranging_mb7389; //V[g^Cv(5m)
+extern const struct ranging_sensor ranging_mb7388; //V[g^Cv(10m)
+extern const struct ranging_sensor ranging_mb7051; //O^Cv(10m)
+
+//Mt[ (Rxxxx<CR>)
+struct ranging_frame {
+	int16_t value; //Ml
+	uint8_t digits; //M
+	bool invalid;   //ȊOM
+	bool done;      //CRMς
+};
+
+//DIPXCb`(SW2, SW3)ZT[@I
+const struct ranging_sensor *ranging_select(int sw2, int sw3);
+
+//LȌvl̒l (LȒlȂꍇRANGING_ERROR)
+int16_t ranging_median(const int16_t *range_mm, int count);
+
+//vlG[̌ (3ȏŃgC)
+int ranging_error_count(const int16_t *range_mm, int count);
+
+//lRANGING_MEDIAN_WINDOW_MM̌vl̕ (LȒlȂꍇRANGING_ERROR)
+int16_t ranging_reliable(const int16_t *range_mm, int count);
+
+//̉x␳W (Q16) x1/16P (TMP102̕\)
+uint32_t ranging_temp_factor_q16(int16_t temp_c16);
+
+//vl̉x␳ (G[l͂̂܂)
+static inline int16_t ranging_compensate(int16_t mm, uint32_t factor_q16)
+{
+	if (mm < 0) {
+		return mm;
+	}
+	return (int16_t)(((uint32_t)mm * factor_q16 + 0x8000) >> 16);
+}
+
+//t[MJn
+static inline void ranging_frame_reset(struct ranging_frame *frame)
+{
+	frame->value = 0;
+	frame->digits = 0;
+	frame->invalid = false;
+	frame->done = false;
+}
+
+//t[1ǉ (CRMtrue)
+static inline bool ranging_frame_push(struct ranging_frame *frame, char c)
+{
+	if (c == '\r') {
+		frame->done = true;
+	} else if (c >= '0' && c <= '9' && frame->digits < 4) {
+		frame->value = frame->value * 10 + (c - '0');
+		frame->digits++;
+	} else if (c != 'R') {
+		frame->invalid = true;
+	}
+	return frame->done;
+}
+
+//UARTM̃^CAEg (t[o͎RANGING_TIMEOUT_FRAMES{)
+static inline int ranging_timeout_ms(const struct ranging_sensor *sensor)
+{
+	return sensor->frame_period_ms * RANGING_TIMEOUT_FRAMES;
+}
+
+//Mt[mmɕϊ (osE͈͊OEst[RANGING_ERROR)
+static inline int16_t ranging_convert(const struct ranging_sensor *sensor, const struct ranging_frame *frame)
+{
+	int32_t mm;
+
+	if (frame->invalid || frame->digits == 0 || frame->value == sensor->no_target) {
+		return RANGING_ERROR;
+	}
+	mm = (int32_t)frame->value * sensor->unit_mm;
+	if (mm <= sensor->min_mm || mm > sensor->max_mm) {
+		return RANGING_ERROR;
+	}
+	return (int16_t)mm;
+}
+
+#endif /* RANGING_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+#include <stdint.h>
+
+#define SCHEDULE_NO_SLOT UINT32_MAX //T[ow̑MʒuȂ
+
+//ICCID狁߂鑗Mʒu (M̃ItZbgmsBICCID͏ɓl)
+uint32_t schedule_phase_ms(const char *iccid, uint32_t period_ms);
+
+// (AT+CCLK? ["23/10/18,12:00:00+36"]) 2000N11̕bɕϊ (sȕ-1)
+int64_t schedule_cclk_to_s(const char *cclk);
+
+//̑Mʒu܂ł̑҂ms (now_ms𑗐MŊ]肪phase_msƂȂ鎞Bmin_ms̏ꍇ͎̎)
+uint32_t schedule_next_ms(int64_t now_ms, uint32_t phase_ms, uint32_t period_ms, uint32_t min_ms);
+
+//҂ԂɃWb^ (base_ms50%`150%ɈlɕU)
+uint32_t schedule_jitter_ms(uint32_t base_ms, uint32_t random);
+
+#endif /* SCHEDULE_H_ */
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SEQNO_H_
+#define SEQNO_H_
+
+#include <stdint.h>
+
+#define SEQNO_RESERVE 256 //tbVɕۑԊu (df̋Nł͂̐܂Ŕԍ΂)
+
+//V[PXԍ (N񐔂ZătbVɕۑ)
+int seqno_init(void);
+
+//N (dEWDTEVXeZbg܂)
+uint32_t seqno_boot_count(void);
+
+//̃V[PXԍ (Mf[^Ƃ1ZAZbgEdf܂ŒP)
+uint32_t seqno_next(void);
+
+#endif /* SEQNO_H_ */
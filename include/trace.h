@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//g[XR[h` [ 1oCg][OR[ȟoms 2oCgLE][f[^ 1oCg][f[^]
+#define TRACE_RECORD_HDR_SIZE 4
+
+//g[XR[h
+enum trace_type {
+	TRACE_CYCLE = 'C',   //vEM̊Jn (f[^: Nms 4oCgLE + ZT[@햼)
+	TRACE_UART = 'U',    //gZT[MoCg (5msȏ̊ԊuŎ̃R[hɕ)
+	TRACE_AT_CMD = 'A',  //ATR}h
+	TRACE_AT_RESP = 'R', //ATR}h (͑O̕)
+	TRACE_EVENT = 'E',   //茋 (f[^: Cxgԍ 1oCg + l 2oCgLE)
+};
+
+//茋
+enum trace_event {
+	TRACE_EV_TIMEOUT,        //gZT[Ȃ (l: Mς݃t[)
+	TRACE_EV_SENSING,        //vlG[ (l: G[)
+	TRACE_EV_RETRY,          //vgC (l: )
+	TRACE_EV_XMONITOR_ERROR, //AT%XMONITOR 擾s
+	TRACE_EV_CONEVAL_ERROR,  //AT%CONEVAL 擾s
+	TRACE_EV_ALARM,          //xv (l: alarm_cause)
+	TRACE_EV_SEND_ERROR,     //Ms (l: errno)
+	TRACE_EV_LINK_RECOVERY,  //N (l: link_recovery)
+	TRACE_EV_DEFER,          //M (l: GlM[lAMꍇ -defer_decision)
+};
+
+#if defined(CONFIG_UDP_TRACE_ENABLE)
+//g[X (tbV݈̏ʒuǂݍ)
+int trace_init(void);
+
+//̊Jn (RAMobt@NA)
+void trace_begin(const char *sensor_name);
+
+//gZT[M1oCg
+void trace_uart(char c);
+
+//ATR}hƉ
+void trace_at(const char *cmd, const char *response);
+
+//茋 (ُCxg͎̏IɃtbV֕ۑ)
+void trace_event(enum trace_event event, int16_t value);
+
+//̏I (ُ킪A܂CONFIG_UDP_TRACE_ALL̏ꍇ̓tbṼOɕۑ)
+void trace_end(void);
+
+//ۑς݃g[XR\[ɏo (TRACE,<Xbg>,<16i>)
+void trace_dump(void);
+
+//ۑς݃g[X𑗐M (_EN̗v [TRACE] ɉ)
+void trace_send(int fd);
+#else
+static inline int trace_init(void) { return 0; }
+static inline void trace_begin(const char *sensor_name) {}
+static inline void trace_uart(char c) {}
+static inline void trace_at(const char *cmd, const char *response) {}
+static inline void trace_event(enum trace_event event, int16_t value) {}
+static inline void trace_end(void) {}
+static inline void trace_dump(void) {}
+static inline void trace_send(int fd) {}
+#endif
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef UPLINK_QUEUE_H_
+#define UPLINK_QUEUE_H_
+
+#define UPLINK_QUEUE_LEN 4      //ێ関Mf[^
+#define UPLINK_PAYLOAD_SIZE 256 //Mf[^ő咷(I[܂)
+
+//Mf[^L[ (ZbgÕf[^LłΈp)
+void uplink_queue_init(void);
+
+//Mf[^ǉ (t̏ꍇ͍łÂf[^j)
+void uplink_queue_push(const char *payload);
+
+//łÂMf[^ (̏ꍇNULL)
+const char *uplink_queue_peek(void);
+
+//łÂMf[^폜
+void uplink_queue_pop(void);
+
+//Mf[^
+int uplink_queue_count(void);
+
+#endif /* UPLINK_QUEUE_H_ */
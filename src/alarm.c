@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "alarm.h"
+
+//x񔻒
+//ʂl: CONFIG_UDP_ALARM_DISTANCE_MMȉŌxBl+qXeVX𒴂܂ōČx񂵂Ȃ
+//㏸x: O񔻒肩̋̌CONFIG_UDP_ALARM_RISE_MM_PER_MINȏŌx (0Ŗ)
+//Ǒx񂩂CONFIG_UDP_ALARM_HOLDOFF_SECONDSȓ͍Čx񂵂Ȃ
+enum alarm_cause alarm_evaluate(struct alarm_state *state, int16_t distance_mm, int64_t now_ms)
+{
+	enum alarm_cause cause = ALARM_NONE;
+	bool holdoff = (state->sent_ms != 0 && now_ms - state->sent_ms < CONFIG_UDP_ALARM_HOLDOFF_SECONDS * 1000LL);
+
+	if (distance_mm < 0) {
+		return ALARM_NONE;
+	}
+
+	if (distance_mm <= CONFIG_UDP_ALARM_DISTANCE_MM) {
+		if (!state->level_latched && !holdoff) {
+			state->level_latched = true;
+			cause = ALARM_LEVEL;
+		}
+	} else if (distance_mm > CONFIG_UDP_ALARM_DISTANCE_MM + CONFIG_UDP_ALARM_HYSTERESIS_MM) {
+		state->level_latched = false;
+	}
+
+	if (CONFIG_UDP_ALARM_RISE_MM_PER_MIN > 0 && cause == ALARM_NONE && !holdoff && state->last_ms != 0 && now_ms > state->last_ms) {
+		int32_t rise_mm = state->last_mm - distance_mm;
+		int64_t rise_per_min = (int64_t)rise_mm * 60000 / (now_ms - state->last_ms);
+
+		if (rise_per_min >= CONFIG_UDP_ALARM_RISE_MM_PER_MIN) {
+			cause = ALARM_RISE;
+		}
+	}
+
+	state->last_mm = distance_mm;
+	state->last_ms = now_ms;
+
+	if (cause != ALARM_NONE) {
+		state->sent_ms = now_ms;
+	}
+
+	return cause;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "at_parse.h"
+
+#define AT_FIELD_COUNT 17 //̍ő區ڐ
+#define AT_FIELD_SIZE 12  //1ڂ̍ő咷
+
+//J}؂̉ڂɕ (߂l͍ڐ)
+static int at_split(char *response, char fields[AT_FIELD_COUNT][AT_FIELD_SIZE])
+{
+	char *pt;
+	int a = 0;
+
+	memset(fields, 0, AT_FIELD_COUNT * AT_FIELD_SIZE);
+	pt = strtok(response, ",");
+	while (pt != NULL && a < AT_FIELD_COUNT) {
+		snprintf(fields[a], AT_FIELD_SIZE, "%s", pt);
+		a++;
+		pt = strtok(NULL, ",");
+	}
+
+	return a;
+}
+
+//AT%XMONITOR̉
+// [5,"KDDI","KDDI","44051","185C",7,18,"008AAA5C",316,5900,44,22,"1010","00000000","00100111","01011111"]
+bool at_parse_xmonitor(char *response, struct xmonitor_info *info)
+{
+	char fields[AT_FIELD_COUNT][AT_FIELD_SIZE];
+
+	at_split(response, fields);
+
+	//o^ 5:[~Oo^ς (SIM͏Ƀ[~O)
+	if (fields[0][0] == '5') {
+		snprintf(info->plmn   , sizeof(info->plmn)   , "%.7s" , fields[3]);
+		snprintf(info->tac    , sizeof(info->tac)    , "%.6s" , fields[4]);
+		snprintf(info->band   , sizeof(info->band)   , "%.2s" , fields[6]);
+		snprintf(info->cell_id, sizeof(info->cell_id), "%.10s", fields[7]);
+		return true;
+	}
+
+	sprintf(info->plmn   ,   "\"00000\"" );  // PLMN G[l
+	sprintf(info->tac    ,    "\"0000\"" );  // TACR[h G[l
+	sprintf(info->band   ,           "0" );  // ohԍ G[l
+	sprintf(info->cell_id, "\"00000000\"");  // CELL ID G[l
+	return false;
+}
+
+//AT%CONEVAL̉
+// [0,0,6,42,3,17,"008AAA5C","44051",331,5900,18,0,0,4,2,8,117]
+bool at_parse_coneval(char *response, struct coneval_info *info)
+{
+	char fields[AT_FIELD_COUNT][AT_FIELD_SIZE];
+
+	at_split(response, fields);
+
+	// 0:]
+	if (strcmp(fields[0], "0") == 0) {
+		snprintf(info->es  , sizeof(info->es)  , "%.1s", fields[2]);
+		snprintf(info->rsrp, sizeof(info->rsrp), "%.3s", fields[3]);
+		snprintf(info->rsrq, sizeof(info->rsrq), "%.3s", fields[4]);
+		snprintf(info->snr , sizeof(info->snr) , "%.3s", fields[5]);
+		return true;
+	}
+
+	sprintf(info->es  , "0");   // d͌ G[l
+	sprintf(info->rsrp, "255"); // MMd G[l
+	sprintf(info->rsrq, "255"); // MMi G[l
+	sprintf(info->snr , "127"); // MmCY G[l
+	return false;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "batt.h"
+
+//ADCTv̕ςddmVɊZ
+int16_t batt_mv(const int16_t *samples, int count)
+{
+	int32_t sum = 0;
+	int a;
+
+	for (a = 0; a < count; a++) {
+		sum += samples[a];
+	}
+
+	double adc_value = (double)(sum / count);
+	adc_value = adc_value * 3600.0; // MAX3.6V
+	adc_value = adc_value / 4095.0; // 12bit
+	adc_value = adc_value * 1.529411765; // R
+
+	return (int16_t)adc_value;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include "defer.h"
+
+//GlM[lƂ̑M1񂠂̐d͗ (9:Excellent 10ƂΒl)
+//5:Bad őJԂM 6:Poor ڑgCEJԂ 7:Normal JԂ 8:Good
+//JobWǧJԂ񐔂̊TẐ߁A̎ɍ킹Ē
+static const uint16_t defer_cost_table[5] = { 80, 40, 20, 14, 10 };
+
+//M1񂠂̐d͗
+uint16_t defer_cost(int es)
+{
+	if (es < 5 || es > 9) {
+		return DEFER_COST_UNIT;
+	}
+	return defer_cost_table[es - 5];
+}
+
+//Mԏ
+//ZbgȌԂLȂWvlpB͋N̎Ԃ̂߁Ãf[^͋N_琔
+//Mf[^Ăꍇ͉̃f[^ȂƂ
+void defer_init(struct defer_state *state, int queued)
+{
+	if (state->magic != DEFER_MAGIC) {
+		memset(state, 0, sizeof(*state));
+		state->magic = DEFER_MAGIC;
+		return;
+	}
+	state->oldest_ms = 0;
+	if (state->pending > queued) {
+		state->pending = 0;
+		state->pending_cost = 0;
+	}
+}
+
+//M
+//GlM[lCONFIG_UDP_DEFER_MIN_ESA܂͎Md͂CONFIG_UDP_DEFER_MIN_RSRP_DBM̏ꍇ͉
+//xÃf[^̎CONFIG_UDP_DEFER_DEADLINE_SECONDS𒴂ꍇAMf[^t̏ꍇ͑M
+//AT%CONEVAL擾łȂꍇ (es 5`9ȊO) ͉Ȃ
+enum defer_decision defer_evaluate(struct defer_state *state, int es, int rsrp_dbm, bool urgent, bool queue_full,
+                                   int64_t now_ms)
+{
+	bool poor = (es >= 5 && es <= 9) &&
+	            (es < CONFIG_UDP_DEFER_MIN_ES || rsrp_dbm < CONFIG_UDP_DEFER_MIN_RSRP_DBM);
+	int64_t oldest_ms = state->pending > 0 ? state->oldest_ms : now_ms;
+
+	if (!poor) {
+		return DEFER_SEND;
+	}
+	if (urgent) {
+		state->forced++;
+		return DEFER_SEND_URGENT;
+	}
+	if (queue_full ||
+	    now_ms - oldest_ms + CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS * 1000LL > CONFIG_UDP_DEFER_DEADLINE_SECONDS * 1000LL) {
+		state->forced++;
+		return DEFER_SEND_DEADLINE;
+	}
+
+	if (state->pending == 0) {
+		state->oldest_ms = now_ms;
+	}
+	state->pending++;
+	state->pending_cost += defer_cost(es);
+	state->deferred++;
+
+	return DEFER_HOLD;
+}
+
+//M
+void defer_sent(struct defer_state *state, int es)
+{
+	if (state->pending == 0) {
+		return;
+	}
+
+	state->saved += (int32_t)state->pending_cost - (int32_t)state->pending * defer_cost(es);
+	state->pending = 0;
+	state->pending_cost = 0;
+	state->oldest_ms = 0;
+}
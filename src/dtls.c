@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
+#include <modem/modem_key_mgmt.h>
+
+#include "dtls.h"
+
+//ÍXC[g TLS_PSK_WITH_AES_128_CCM_8 (R[h̑16oCgōŏ)
+static const int dtls_cipher_list[] = { 0xC0A8 };
+
+//PSKEPSK IDfɏ (lݍς݂̏ꍇ̓tbVȂ)
+static int dtls_provision(enum modem_key_mgmt_cred_type type, const char *value)
+{
+	int err;
+
+	if (value[0] == '\0') {
+		return 0; //Ho׎AT%CMNGŏݍς
+	}
+
+	err = modem_key_mgmt_cmp(CONFIG_UDP_DTLS_SEC_TAG, type, value, strlen(value));
+	if (err == 0) {
+		return 0;
+	}
+
+	err = modem_key_mgmt_write(CONFIG_UDP_DTLS_SEC_TAG, type, value, strlen(value));
+	if (err) {
+		printk("Failed to provision DTLS credential %d, err %d\n", type, err);
+		return err;
+	}
+	printk("DTLS credential %d provisioned\n", type);
+
+	return 0;
+}
+
+//DTLS
+int dtls_init(void)
+{
+	int err;
+
+	err = dtls_provision(MODEM_KEY_MGMT_CRED_TYPE_PSK, CONFIG_UDP_DTLS_PSK);
+	if (err) {
+		return err;
+	}
+
+	return dtls_provision(MODEM_KEY_MGMT_CRED_TYPE_IDENTITY, CONFIG_UDP_DTLS_PSK_IDENTITY);
+}
+
+//DTLS\Pbgݒ
+int dtls_socket_setup(int fd)
+{
+	int err;
+	sec_tag_t sec_tag_list[] = { CONFIG_UDP_DTLS_SEC_TAG };
+	int verify = TLS_PEER_VERIFY_REQUIRED;
+	int cache = TLS_SESSION_CACHE_ENABLED;
+
+	err = setsockopt(fd, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list, sizeof(sec_tag_list));
+	if (err) {
+		printk("Failed to set DTLS sec tag: %d\n", errno);
+		return -errno;
+	}
+
+	err = setsockopt(fd, SOL_TLS, TLS_CIPHERSUITE_LIST, dtls_cipher_list, sizeof(dtls_cipher_list));
+	if (err) {
+		printk("Failed to set DTLS cipher suite: %d\n", errno);
+		return -errno;
+	}
+
+	err = setsockopt(fd, SOL_TLS, TLS_PEER_VERIFY, &verify, sizeof(verify));
+	if (err) {
+		printk("Failed to set DTLS peer verify: %d\n", errno);
+		return -errno;
+	}
+
+	//ZbVLbV \Pbgč쐬͒ZknhVFCNōĊJ
+	err = setsockopt(fd, SOL_TLS, TLS_SESSION_CACHE, &cache, sizeof(cache));
+	if (err) {
+		printk("Failed to enable DTLS session cache: %d\n", errno);
+	}
+
+#if defined(TLS_DTLS_CID)
+	//Connection ID (RFC 9146) NAT̍Ċ蓖ČnhVFCNȂőM𑱂
+	int cid = TLS_DTLS_CID_SUPPORTED;
+
+	err = setsockopt(fd, SOL_TLS, TLS_DTLS_CID, &cid, sizeof(cid));
+	if (err) {
+		printk("Failed to enable DTLS Connection ID: %d\n", errno);
+	}
+#else
+	printk("DTLS Connection ID is not supported by this SDK\n");
+#endif
+
+	return 0;
+}
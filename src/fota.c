@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/dfu/mcuboot.h>
+#include <dfu/dfu_target.h>
+#include <dfu/dfu_target_mcuboot.h>
+#include <pm_config.h>
+
+#include "fota.h"
+
+//FOTAvgR
+//v ([T[o)  [FOTA,<ICCID>,<so[W>,<C[WCRC32(16i)>,<vItZbg>]
+// (T[o[) 24oCgwb_ + `Nf[^ (l͑SăgGfBA)
+//  [0-1]   }WbN 'F','W'
+//  [2]     Xe[^X 0:`N 1:XVȂ
+//  [3]     \
+//  [4-7]   C[WTCY
+//  [8-11]  C[WŜCRC32
+//  [12-15] `NItZbg
+//  [16-17] `N
+//  [18-19] \
+//  [20-23] `NCRC32
+#define FOTA_HDR_SIZE 24
+#define FOTA_STATUS_CHUNK 0
+#define FOTA_STATUS_NO_UPDATE 1
+
+struct fota_image_info {
+	uint32_t size; //C[WTCY
+	uint32_t crc;  //C[WŜCRC32
+};
+
+static struct fota_image_info fota_image; //_E[h̃C[W(ݒ̈ɕۑAZbgp)
+static bool fota_target_ready;            //dfu_targetς݃tO
+static uint8_t fota_dfu_buf[1024];        //tbV݃obt@
+static uint8_t fota_rx_buf[FOTA_HDR_SIZE + CONFIG_UDP_FOTA_CHUNK_SIZE];
+
+//ݒ̈悩_E[hC[W𕜌
+static int fota_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	if (strcmp(name, "img") == 0 && len == sizeof(fota_image)) {
+		if (read_cb(cb_arg, &fota_image, sizeof(fota_image)) != sizeof(fota_image)) {
+			memset(&fota_image, 0, sizeof(fota_image));
+			return -EINVAL;
+		}
+		return 0;
+	}
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(fota, "fota", NULL, fota_settings_set, NULL, NULL);
+
+static void fota_dfu_cb(enum dfu_target_evt_id evt)
+{
+	ARG_UNUSED(evt);
+}
+
+//dfu_target (ۑς݂݈̏ʒu΂ĊJ)
+static int fota_target_open(void)
+{
+	int err;
+
+	if (fota_target_ready) {
+		return 0;
+	}
+
+	err = dfu_target_mcuboot_set_buf(fota_dfu_buf, sizeof(fota_dfu_buf));
+	if (err) {
+		printk("dfu_target_mcuboot_set_buf failed: %d\n", err);
+		return err;
+	}
+
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, 0, fota_image.size, fota_dfu_cb);
+	if (err) {
+		printk("dfu_target_init failed: %d\n", err);
+		return err;
+	}
+
+	fota_target_ready = true;
+	return 0;
+}
+
+//_E[hC[W̔j
+static void fota_discard(void)
+{
+	if (fota_image.size != 0 && fota_target_open() == 0) {
+		dfu_target_reset();
+	}
+	fota_target_ready = false;
+
+	memset(&fota_image, 0, sizeof(fota_image));
+	settings_delete("fota/img");
+}
+
+//ZJ_Xbgɏ񂾃C[WCRC32
+static int fota_verify(void)
+{
+	const struct flash_area *fa;
+	uint8_t buf[256];
+	uint32_t crc = 0;
+	uint32_t off;
+	size_t len;
+	int err;
+
+	err = flash_area_open(PM_MCUBOOT_SECONDARY_ID, &fa);
+	if (err) {
+		return err;
+	}
+
+	for (off = 0; off < fota_image.size; off += len) {
+		len = MIN(sizeof(buf), fota_image.size - off);
+		err = flash_area_read(fa, off, buf, len);
+		if (err) {
+			break;
+		}
+		crc = crc32_ieee_update(crc, buf, len);
+	}
+	flash_area_close(fa);
+
+	if (err) {
+		return err;
+	}
+	printk("FOTA image crc %08x (expected %08x)\n", crc, fota_image.crc);
+
+	return (crc == fota_image.crc) ? 0 : -EBADMSG;
+}
+
+//_E[h (،ɎÑXbv\)
+static int fota_finish(void)
+{
+	int err;
+
+	err = dfu_target_done(true);
+	fota_target_ready = false;
+	if (err) {
+		printk("dfu_target_done failed: %d\n", err);
+		fota_discard();
+		return err;
+	}
+
+	err = fota_verify();
+	if (err) {
+		printk("FOTA image verify failed: %d\n", err);
+		fota_discard();
+		return err;
+	}
+
+	err = dfu_target_schedule_update(0);
+	if (err) {
+		printk("dfu_target_schedule_update failed: %d\n", err);
+		fota_discard();
+		return err;
+	}
+
+	memset(&fota_image, 0, sizeof(fota_image));
+	settings_delete("fota/img");
+	printk("FOTA image verified, swap scheduled\n");
+
+	return 1;
+}
+
+//FOTA
+int fota_init(void)
+{
+	int err;
+
+	err = settings_subsys_init();
+	if (err) {
+		printk("settings_subsys_init failed: %d\n", err);
+		return err;
+	}
+
+	err = settings_load_subtree("fota");
+	if (err) {
+		printk("settings_load_subtree failed: %d\n", err);
+		return err;
+	}
+
+	printk("FOTA version %s", CONFIG_MCUBOOT_IMAGE_VERSION);
+	if (fota_image.size != 0) {
+		printk(", resume image size %u crc %08x", fota_image.size, fota_image.crc);
+	}
+	printk("\n");
+
+	return 0;
+}
+
+//NC[W̊m
+void fota_confirm_image(void)
+{
+	if (boot_is_img_confirmed()) {
+		return;
+	}
+
+	if (boot_write_img_confirmed() == 0) {
+		printk("FOTA image confirmed\n");
+	} else {
+		printk("FOTA image confirm failed\n");
+	}
+}
+
+//_E[hr̃C[W
+bool fota_in_progress(void)
+{
+	return fota_image.size != 0;
+}
+
+//FOTA
+int fota_process(const char *iccid, uint32_t budget_ms)
+{
+	int64_t start_ms = k_uptime_get();
+	struct sockaddr_in server = {
+		.sin_family = AF_INET,
+		.sin_port = htons(CONFIG_UDP_FOTA_SERVER_PORT),
+	};
+	struct timeval timeout = {
+		.tv_sec = CONFIG_UDP_FOTA_RECV_TIMEOUT_MSEC / 1000,
+		.tv_usec = (CONFIG_UDP_FOTA_RECV_TIMEOUT_MSEC % 1000) * 1000,
+	};
+	char request[80];
+	size_t offset = 0;
+	int count;
+	int ret = 0;
+	int err;
+	int fd;
+
+	inet_pton(AF_INET, CONFIG_UDP_SERVER_ADDRESS_STATIC, &server.sin_addr);
+
+	//fĂ_E[h݈̏ʒu擾
+	if (fota_image.size != 0) {
+		err = fota_target_open();
+		if (err == 0) {
+			err = dfu_target_offset_get(&offset);
+		}
+		if (err) {
+			fota_discard();
+			offset = 0;
+		}
+	}
+
+	fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (fd < 0) {
+		printk("Failed to create FOTA socket: %d\n", errno);
+		return -errno;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	err = connect(fd, (struct sockaddr *)&server, sizeof(server));
+	if (err < 0) {
+		printk("FOTA connect failed: %d\n", errno);
+		close(fd);
+		return -errno;
+	}
+
+	for (count = 0; count < CONFIG_UDP_FOTA_CHUNKS_PER_CYCLE; count++) {
+		//҂ŎԂ𒴂ꍇ͎̎ɉ
+		if (k_uptime_get() - start_ms + CONFIG_UDP_FOTA_RECV_TIMEOUT_MSEC > budget_ms) {
+			break;
+		}
+		snprintf(request, sizeof(request), "FOTA,%s,%s,%08x,%zu", iccid, CONFIG_MCUBOOT_IMAGE_VERSION, fota_image.crc, offset);
+		if (send(fd, request, strlen(request), 0) < 0) {
+			printk("FOTA request send failed: %d\n", errno);
+			ret = -errno;
+			break;
+		}
+
+		//M^CAEg̓T[os݂Ƃđł؂ (͎̎)
+		int len = recv(fd, fota_rx_buf, sizeof(fota_rx_buf), 0);
+		if (len < 0) {
+			printk("FOTA no response\n");
+			break;
+		}
+		if (len < FOTA_HDR_SIZE || fota_rx_buf[0] != 'F' || fota_rx_buf[1] != 'W') {
+			continue;
+		}
+
+		if (fota_rx_buf[2] == FOTA_STATUS_NO_UPDATE) {
+			if (fota_image.size != 0) {
+				printk("FOTA image withdrawn by server\n");
+				fota_discard();
+			}
+			break;
+		}
+		if (fota_rx_buf[2] != FOTA_STATUS_CHUNK) {
+			continue;
+		}
+
+		uint32_t image_size = sys_get_le32(&fota_rx_buf[4]);
+		uint32_t image_crc = sys_get_le32(&fota_rx_buf[8]);
+		uint32_t chunk_off = sys_get_le32(&fota_rx_buf[12]);
+		uint16_t chunk_len = sys_get_le16(&fota_rx_buf[16]);
+		uint32_t chunk_crc = sys_get_le32(&fota_rx_buf[20]);
+		uint8_t *chunk = &fota_rx_buf[FOTA_HDR_SIZE];
+
+		//VC[W̏ꍇ͓r܂ł̃C[Wjčŏ
+		if (image_size != fota_image.size || image_crc != fota_image.crc) {
+			fota_discard();
+			if (image_size == 0 || image_size > PM_MCUBOOT_SECONDARY_SIZE) {
+				printk("FOTA invalid image size %u\n", image_size);
+				ret = -EFBIG;
+				break;
+			}
+			fota_image.size = image_size;
+			fota_image.crc = image_crc;
+			settings_save_one("fota/img", &fota_image, sizeof(fota_image));
+			printk("FOTA new image size %u crc %08x\n", image_size, image_crc);
+
+			err = fota_target_open();
+			if (err) {
+				fota_discard();
+				ret = err;
+				break;
+			}
+			offset = 0;
+		}
+
+		//vƈقȂItZbgEj`N͔jčėv
+		if (chunk_off != offset || chunk_len != len - FOTA_HDR_SIZE || chunk_off + chunk_len > fota_image.size) {
+			continue;
+		}
+		if (crc32_ieee(chunk, chunk_len) != chunk_crc) {
+			continue;
+		}
+
+		err = dfu_target_write(chunk, chunk_len);
+		if (err) {
+			printk("dfu_target_write failed: %d\n", err);
+			fota_discard();
+			ret = err;
+			break;
+		}
+		offset += chunk_len;
+
+		if (offset >= fota_image.size) {
+			ret = fota_finish();
+			break;
+		}
+	}
+
+	close(fd);
+
+	if (fota_image.size != 0) {
+		printk("FOTA progress %zu/%u\n", offset, fota_image.size);
+	}
+
+	return ret;
+}
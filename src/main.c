@@ -17,7 +17,6 @@
 #include <zephyr/kernel.h>
 #include <zephyr/init.h>
 #include <zephyr/device.h>
-#include <zephyr/pm/device.h>
 #include <zephyr/net/socket.h>
 
 #include <zephyr/drivers/uart.h>
@@ -25,10 +24,38 @@
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/drivers/adc.h>
 #include <zephyr/drivers/watchdog.h>
+#include <zephyr/random/rand32.h>
 #include <modem/lte_lc.h>
 
+#include "ranging.h"
+#include "alarm.h"
+#include "profile.h"
+#include "at_parse.h"
+#include "batt.h"
+#include "payload.h"
+#include "uplink_queue.h"
+#include "power.h"
+#include "trace.h"
+#include "at_parse.h"
+#include "schedule.h"
+#include "seqno.h"
+#include "defer.h"
+
+#if defined(CONFIG_UDP_FOTA_ENABLE)
+#include "fota.h"
+#endif
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+#include "dtls.h"
+#define SERVER_PORT CONFIG_UDP_DTLS_SERVER_PORT //M|[g (DTLS)
+#else
+#define SERVER_PORT CONFIG_UDP_SERVER_PORT //M|[g
+#endif
+
 #define UDP_IP_HEADER_SIZE 28
-#define UART_TIMEOUT_MSEC 1000
+#define PERIOD_MS (CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS * 1000) //M
+#define NEXT_MIN_MS (PERIOD_MS / 2) //̑M܂ł̍ŒZ̑҂ (MʒuςĂMԊu͎1/2ȏ)
+#define CYCLE_BUDGET_MS 30000       //1̏Ԃ̌ (WDTZbg҂Jn܂ + ҂IWDTZbg܂)
+#define WDT_WINDOW_MS (PERIOD_MS + NEXT_MIN_MS + CYCLE_BUDGET_MS) //WDT Œ̑҂ + 
 
 static const struct device *uart_dev = DEVICE_DT_GET(DT_NODELABEL(uart0)); //UART
 
@@ -57,6 +84,46 @@ static struct k_work_delayable server_transmission_work;
 
 static K_SEM_DEFINE(lte_connected, 0, 1);
 static K_SEM_DEFINE(cereg_sem, 0, 1);
+static volatile bool lte_registered; //lbg[No^
+
+//N񕜎菇 (sقǏ̎菇珇Ɏs)
+enum link_recovery {
+	LINK_RECOVERY_SOCKET,   //\Pbgč쐬
+	LINK_RECOVERY_REG_WAIT, //lbg[No^҂
+	LINK_RECOVERY_CFUN,     //CFUN=4/1 ؂ւ
+	LINK_RECOVERY_RESET,    //VXeZbg (ŏIi)
+	LINK_RECOVERY_COUNT
+};
+
+static const char *const link_recovery_name[LINK_RECOVERY_COUNT] = {
+	"socket", "reg_wait", "cfun", "reset",
+};
+
+//N񕜎s(ΏۊOϐ̒` ZbgMf[^ŕ񍐂)
+volatile uint32_t link_recovery_count[LINK_RECOVERY_COUNT] __attribute__((section(".noinit.link")));
+static uint8_t link_fail_cycles; //AMs
+
+//DIPXCb` (NɈxǂݎ)
+static int dip_sw[4];
+
+//gZT[@ (CONFIG_UDP_SENSOR_*)
+#if defined(CONFIG_UDP_SENSOR_MB7051)
+#define PROFILE_SENSOR ranging_mb7051
+#elif defined(CONFIG_UDP_SENSOR_MB7388)
+#define PROFILE_SENSOR ranging_mb7388
+#else
+#define PROFILE_SENSOR ranging_mb7389
+#endif
+
+//gZT[@I
+//DIPXCb` 2ԁE3Ԃ̂ǂ炩ON̏ꍇDIPXCb`ɏ] (CONFIG_UDP_DIP_OVERRIDE)
+static const struct ranging_sensor *sensor_select(void)
+{
+	if (IS_ENABLED(CONFIG_UDP_DIP_OVERRIDE) && (dip_sw[2] || dip_sw[3])) {
+		return ranging_select(dip_sw[2], dip_sw[3]);
+	}
+	return &PROFILE_SENSOR;
+}
 
 //GPIO
 static int gpio_init(void)
@@ -76,21 +143,28 @@ static int gpio_init(void)
 	}
 
 	//̓s
-	ret = gpio_pin_configure_dt(&SW0, GPIO_INPUT | GPIO_PULL_UP);
-	if (ret) {
-		printk("\n **** Configure SW0 pin failed (%d) ****",ret);
-	}
-	ret = gpio_pin_configure_dt(&SW1, GPIO_INPUT | GPIO_PULL_UP);
-	if (ret) {
-		printk("\n **** Configure SW1 pin failed (%d) ****",ret);
-	}
-	ret = gpio_pin_configure_dt(&SW2, GPIO_INPUT | GPIO_PULL_UP);
-	if (ret) {
-		printk("\n **** Configure SW2 pin failed (%d) ****",ret);
-	}
-	ret = gpio_pin_configure_dt(&SW3, GPIO_INPUT | GPIO_PULL_UP);
-	if (ret) {
-		printk("\n **** Configure SW3 pin failed (%d) ****",ret);
+	//DIPXCb`̓vAbvLɂĈxǂݎǍvAbv؂藣
+	//(OÑXCb`vAbvoRŏ펞d𗬂Ȃ悤ɂ)
+	//CONFIG_UDP_DIP_OVERRIDE=n̏ꍇ͓ǂݎȂ (s͐؂藣܂)
+	if (IS_ENABLED(CONFIG_UDP_DIP_OVERRIDE)) {
+		const struct gpio_dt_spec *sw[4] = { &SW0, &SW1, &SW2, &SW3 };
+		int a;
+
+		for (a = 0; a < 4; a++) {
+			ret = gpio_pin_configure_dt(sw[a], GPIO_INPUT | GPIO_PULL_UP);
+			if (ret) {
+				printk("\n **** Configure SW%d pin failed (%d) ****", a, ret);
+			}
+		}
+		k_busy_wait(100); //vAbv҂
+		for (a = 0; a < 4; a++) {
+			dip_sw[a] = gpio_pin_get_dt(sw[a]);
+			ret = gpio_pin_configure_dt(sw[a], GPIO_DISCONNECTED);
+			if (ret) {
+				printk("\n **** Disconnect SW%d pin failed (%d) ****", a, ret);
+			}
+		}
+		printk("DIP-SW status [%d:%d:%d:%d]\n", dip_sw[0], dip_sw[1], dip_sw[2], dip_sw[3]);
 	}
 
 	//o̓s
@@ -186,22 +260,27 @@ int i2c_init(void) {
 	return 0;
 }
 
-//xv
-float measure_temp() {
-	uint8_t I2C_BUFF[3]; //I2Cf[^obt@
-	int err;
+#define TEMP_ERROR_C16 (99 * 16) //xvG[ (99)
+
+//xv TMP102 VbgϊJn
+//ϊ(ő35ms)͒gZT[̌vƕsčsAvtmp102_readœǂݏo
+static int tmp102_start(void) {
+	uint8_t I2C_BUFF[2]; //I2Cf[^obt@
 
 	I2C_BUFF[0] = 0x01; //|C^WX^(RtBO[VWX^Zbg)
 	I2C_BUFF[1] = 0x81; //RtBO[VWX^(VbgLVbg_E[hL)
-	err = write_bytes(i2c_dev, I2C_BUFF, 2, 0x48); //I2C2oCg
-	if (err != 0) {
-		return 99;
-	}
+	return write_bytes(i2c_dev, I2C_BUFF, 2, 0x48); //I2C2oCg
+}
+
+//xv TMP102 ϊʓǂݏo (1/16P)
+static int16_t tmp102_read(void) {
+	uint8_t I2C_BUFF[3]; //I2Cf[^obt@
+	int err;
 
 	//xϊ҂
 	err = read_bytes(i2c_dev, 0x01, I2C_BUFF, 1, 0x48);
 	if (err != 0) {
-		return 99;
+		return TEMP_ERROR_C16;
 	}
 
 	while (I2C_BUFF[0] != 0x01)
@@ -209,20 +288,63 @@ float measure_temp() {
 		err = read_bytes(i2c_dev, 0x01, I2C_BUFF, 1, 0x48);
 	}
 	if (err != 0) {
-		return 99;
+		return TEMP_ERROR_C16;
 	}
 
 	//xvlǂݏo
 	err = read_bytes(i2c_dev, 0x00, I2C_BUFF, 2, 0x48);
 	if (err != 0) {
-		return 99;
+		return TEMP_ERROR_C16;
 	}
 
 	//rbgZ
 	uint16_t uv = ((uint16_t)I2C_BUFF[0] << 8) | I2C_BUFF[1]; //vl16bitɌ
 	int16_t v = (int16_t)uv; //̕ϐɕϊ
 	v >>= 4; //̏ԂŌvl𐳂ɃVtg
-	return (float)v/16.0; //1bit𑜓x0.0625̂16Ŋď_Ŗ߂
+	return v; //1bit𑜓x0.0625 (1/16Pʂ̂܂ܕԂ)
+}
+
+static bool temp_started; //TMP102 ϊJnς
+
+//xvJn (ϊI2C~Ă)
+static void measure_temp_start(void) {
+	int err;
+
+	power_get(POWER_I2C); //I2CN
+	err = tmp102_start();
+	power_put(POWER_I2C); //I2C~
+	temp_started = (err == 0);
+	if (err != 0) {
+		printk("TMP102 start failed (%d)\n", err);
+	}
+}
+
+//xv (1/16P measure_temp_startŕϊJnς)
+int16_t measure_temp() {
+	int16_t temp;
+
+	if (!temp_started) {
+		return TEMP_ERROR_C16; //ϊJnɎs (҂Ȃ)
+	}
+	temp_started = false;
+	power_get(POWER_I2C); //I2CN
+	temp = tmp102_read();
+	power_put(POWER_I2C); //I2C~
+
+	return temp;
+}
+
+//߂̉̉x␳W (Q16 ȈՌvłg)
+static uint32_t temp_factor_q16 = RANGING_TEMP_FACTOR_ONE;
+
+//x␳W̍XV ZT[ŕ␳@ExvG[͕␳Ȃ
+static void temp_factor_update(const struct ranging_sensor *sensor, int16_t temp_c16)
+{
+	if (sensor->temp_compensated || temp_c16 == TEMP_ERROR_C16) {
+		temp_factor_q16 = RANGING_TEMP_FACTOR_ONE;
+	} else {
+		temp_factor_q16 = ranging_temp_factor_q16(CLAMP(temp_c16, -40 * 16, 85 * 16));
+	}
 }
 
 //ADC
@@ -243,12 +365,9 @@ int adc_init(void) {
 //obe[dv
 int16_t measure_batt_mv() {
 	int err;
-	int16_t a_sample_buffer[10] = {0};
-	int16_t s_sample_buffer = 0;
+	int16_t a_sample_buffer[BATT_SAMPLES] = {0};
 	int a;
 
-	pm_device_action_run(adc_dev, PM_DEVICE_ACTION_RESUME);
-
 	int16_t m_sample_buffer;
 	const struct adc_sequence sequence = {
 		.channels = BIT(7),
@@ -263,45 +382,34 @@ int16_t measure_batt_mv() {
 		return -1;
 	}
 
+	power_get(POWER_ADC); //ADCN
 	gpio_pin_set_dt(&ADV_EN, 1); //ADV_enable
-	for (a = 0; a < 10; a++) {
+	for (a = 0; a < BATT_SAMPLES; a++) {
 		//k_msleep(1);
 		err = adc_read(adc_dev, &sequence);
 		a_sample_buffer[a] = m_sample_buffer;
 	}
 	gpio_pin_set_dt(&ADV_EN, 0); //ADV desable
+	power_put(POWER_ADC); //ADC~
 	if (err) {
 		printk("ADC read err: %d\n", err);
 	return -1;
 	}
 
-	for (a = 0; a < 10; a++) {
-		//printk("a_sample_buffer[%d]: %d\n", a, a_sample_buffer[a]);
-		s_sample_buffer = s_sample_buffer + a_sample_buffer[a];
-	}
-	s_sample_buffer = s_sample_buffer / 10;
-	//printk("s_sample_buffer: %d\n", s_sample_buffer);
-
-	double adc_value = (double)s_sample_buffer;
-	adc_value = adc_value * 3600.0d; // MAX3.6V
-	adc_value = adc_value / 4095.0d; // 12bit
-	adc_value = adc_value * 1.529411765; // R
-
-	pm_device_action_run(adc_dev, PM_DEVICE_ACTION_SUSPEND);
-
-	return (int16_t)adc_value;
+	return batt_mv(a_sample_buffer, BATT_SAMPLES); //ςēdɊZ (src/batt.c)
 }
 
-//UARTL؂ւ(d͍팸)
-static void uart0_set_enable(bool enable)
+//R\[o͗pUARTL؂ւ
+//ORTTɏo͂\(production)łUARTLɂȂ
+static void console_set_enable(bool enable)
 {
-	const struct device *uart_dev = DEVICE_DT_GET(DT_NODELABEL(uart0));
-
-	if (!device_is_ready(uart_dev)) {
-		return;
+	if (IS_ENABLED(CONFIG_UART_CONSOLE)) {
+		if (enable) {
+			power_get(POWER_UART);
+		} else {
+			power_put(POWER_UART);
+		}
 	}
-
-	pm_device_action_run(uart_dev, enable ? PM_DEVICE_ACTION_RESUME : PM_DEVICE_ACTION_SUSPEND);
 }
 
 //EHb`hbO^C}[JE^(ΏۊOϐ̒`)
@@ -315,14 +423,21 @@ static void wdt_cb(const struct device *wdt_dev, int channel_id)
 	WDT_call_count++; //WDT+1
 }
 
+//T[ow肳ꂽMʒu (M̃ItZbgmsAΏۊOϐ̒`)
+volatile uint32_t server_slot_ms __attribute__((section(".noinit.slot")));
+
+//[̎v (AT+CCLK?) ƋNoߎԂ̍ms
+static int64_t wall_offset_ms;
+static bool wall_valid;
+
 //EHb`hbO^C}[
 static int wdt_init(void)
 {
 	int err;
 
-	//MԊu +30bŐݒ
+	//Œ̑҂ (M1.5{) +30bŐݒ
 	static struct wdt_timeout_cfg wdt_cfg = {
-	    .window.max = (CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS + 30) * 1000,
+	    .window.max = WDT_WINDOW_MS,
 	    .callback = wdt_cb,
 	    .flags = WDT_FLAG_RESET_SOC,
 	};
@@ -354,7 +469,7 @@ static int server_init(void)
 	struct sockaddr_in *server4 = ((struct sockaddr_in *)&host_addr);
 	printk("server_init start\n");
 	server4->sin_family = AF_INET;
-	server4->sin_port = htons(CONFIG_UDP_SERVER_PORT);
+	server4->sin_port = htons(SERVER_PORT);
 
 	inet_pton(AF_INET, CONFIG_UDP_SERVER_ADDRESS_STATIC, &server4->sin_addr);
 
@@ -368,13 +483,21 @@ static void server_disconnect(void)
 	(void)close(client_fd);
 }
 
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+static int dtls_silent_uplinks; //DTLS\Pbg쐬A_ENMĂȂM
+#endif
+
 //UDPڑ
 static int server_connect(void)
 {
 	int err;
 
 	printk("server connect start\n");
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+	client_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_DTLS_1_2); //DTLS\Pbg
+#else
 	client_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP); //\Pbg
+#endif
 	if (client_fd < 0) {
 		printk("Failed to create UDP socket: %d\n", errno);
 		err = -errno;
@@ -382,16 +505,262 @@ static int server_connect(void)
 		return err;
 	}
 
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+	err = dtls_socket_setup(client_fd); //DTLSݒ (nhVFCNconnectŎs)
+	if (err) {
+		server_disconnect();
+		return err;
+	}
+#endif
+
 	err = connect(client_fd, (struct sockaddr *)&host_addr, sizeof(struct sockaddr_in)); //wIPɐڑ
 	if (err < 0) {
 		printk("Connect failed : %d\n", errno);
 		server_disconnect();
 		return err;
 	}
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+	dtls_silent_uplinks = 0;
+#endif
 
 	return 0;
 }
 
+//N 1iKs (lbg[No^ς݂ł0)
+static int link_recover(enum link_recovery step)
+{
+	int err;
+
+	link_recovery_count[step]++;
+	trace_event(TRACE_EV_LINK_RECOVERY, step);
+	printk("Link recovery %s (%u)\n", link_recovery_name[step], link_recovery_count[step]);
+	wdt_feed(wdt_dev, wdt_main_channel); //񕜑҂̊ԂWDTȂ悤ɃZbg
+
+	switch (step) {
+	case LINK_RECOVERY_SOCKET:
+		break;
+	case LINK_RECOVERY_REG_WAIT:
+		k_sem_reset(&lte_connected);
+		if (!lte_registered) {
+			k_sem_take(&lte_connected, K_SECONDS(CONFIG_UDP_LINK_REG_WAIT_SECONDS)); //o^Cxg҂
+		}
+		break;
+	case LINK_RECOVERY_CFUN:
+		k_sem_reset(&lte_connected);
+		err = lte_lc_offline(); //AT+CFUN=4
+		if (err) {
+			printk("lte_lc_offline, error: %d\n", err);
+		}
+		err = lte_lc_normal();  //AT+CFUN=1
+		if (err) {
+			printk("lte_lc_normal, error: %d\n", err);
+		}
+		k_sem_take(&lte_connected, K_SECONDS(35)); //ڑ҂
+		break;
+	default:
+		WDT_call_count++; //N̐ڑ҂΂
+		NVIC_SystemReset(); //VXeZbg
+		break;
+	}
+
+	server_disconnect();    //T[oؒf
+	err = server_connect(); //T[oڑ
+	if (err) {
+		printk("Not able to connect to UDP server\n"); //UDPT[oڑG[
+	}
+
+	return lte_registered ? 0 : -ENOTCONN;
+}
+
+//Mf[^ÂɑM (MłȂf[^͎֎z)
+static int uplink_flush(void)
+{
+	const char *payload;
+	enum link_recovery step = LINK_RECOVERY_SOCKET;
+
+	while ((payload = uplink_queue_peek()) != NULL) {
+		if (send(client_fd, payload, strlen(payload), 0) >= 0) { //UDPMs
+			uplink_queue_pop();
+			printk("Success to transmit UDP packet, %d left\n", uplink_queue_count());
+			step = LINK_RECOVERY_SOCKET;
+			continue;
+		}
+		printk("Failed to transmit UDP packet, %d\n", errno);
+		trace_event(TRACE_EV_SEND_ERROR, errno);
+		if (step == LINK_RECOVERY_RESET) {
+			return -EIO; //Zbg͑M܂Ŏsꍇ̂
+		}
+		link_recover(step++);
+	}
+
+	return 0;
+}
+
+//gZT[t[M (ǂݎ̂ăt[̌countvlƂč̗p)
+//^CAEg͌vl-999-ETIMEDOUTԂ
+static int range_finder_read(const struct ranging_sensor *sensor, int16_t *range_mm, int count)
+{
+	struct ranging_frame frame;
+	int countTimeout;
+	char rx_byte;
+	int err;
+	int a, i;
+
+	for (a = 0; a < sensor->warmup_frames + count; a++) {
+		ranging_frame_reset(&frame);
+		countTimeout = 0;
+		//sR[hM܂1t[ƂĐlɕϊ
+		while (!frame.done) {
+			err = uart_poll_in(uart_dev, &rx_byte); //UARTMf[^1ǂݍ݁B󂾂ꍇ͑҂B
+			if (err != -1) {
+				countTimeout = 0;
+				trace_uart(rx_byte);
+				profile_begin(PROFILE_RANGE_PARSE);
+				ranging_frame_push(&frame, rx_byte);
+				profile_end(PROFILE_RANGE_PARSE);
+			} else {
+				countTimeout++;     //UART̃f[^󂾂ꍇ̓JEgAbv
+				k_msleep(1); //1msX[v
+			}
+			//^CAEg t[10{ (MB7051:1b MB7388/MB7389:1.5b) UARTMłȂꍇ̓^CAEg
+			if (countTimeout > ranging_timeout_ms(sensor)) {
+				printk("*** Range Finder Timeout\n");
+				trace_event(TRACE_EV_TIMEOUT, a);
+				for (i = 0; i < count; i++) {
+					range_mm[i] = RANGING_TIMEOUT;
+				}
+				return -ETIMEDOUT;
+			}
+		}
+		//vlG[ (͈͊OEos-1)
+		if (a >= sensor->warmup_frames) {
+			i = a - sensor->warmup_frames;
+			profile_begin(PROFILE_RANGE_CHECK);
+			range_mm[i] = ranging_convert(sensor, &frame);
+			profile_end(PROFILE_RANGE_CHECK);
+			if (range_mm[i] == RANGING_ERROR) {
+				printk("Sensing ERROR [%d] = %d\n", i + 1, frame.value);
+			}
+		}
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_UDP_ALARM_ENABLE)
+static struct k_work_delayable alarm_sensing_work;
+static struct alarm_state alarm_status;
+static enum alarm_cause alarm_pending = ALARM_NONE; //ȈՌvŌmxv
+
+//xpȈՌv (f͎gpAlߎ̂ݑM)
+static void alarm_sensing_work_fn(struct k_work *work)
+{
+	int16_t range_mm[CONFIG_UDP_ALARM_FRAMES];
+	const struct ranging_sensor *sensor;
+	enum alarm_cause cause;
+	int16_t distance;
+	int64_t remaining_ms;
+
+	//̒M̊ȈՌv̏ꍇ͏ȗ
+	remaining_ms = k_ticks_to_ms_floor64(k_work_delayable_remaining_get(&server_transmission_work));
+	if (remaining_ms < CONFIG_UDP_ALARM_SENSING_SECONDS * 1000) {
+		k_work_schedule(&alarm_sensing_work, K_SECONDS(CONFIG_UDP_ALARM_SENSING_SECONDS));
+		return;
+	}
+
+	power_get(POWER_UART); //UARTL
+	sensor = sensor_select();
+	gpio_pin_set_dt(&WS_POWER, 1); //ZT[dON
+	gpio_pin_set_dt(&WA_START, 1); //ZT[vX^[g
+	k_msleep(170); //NbZ[WM҂
+	range_finder_read(sensor, range_mm, CONFIG_UDP_ALARM_FRAMES);
+	gpio_pin_set_dt(&WA_START, 0); //ZT[v~
+	gpio_pin_set_dt(&WS_POWER, 0); //ZT[dOFF
+
+	distance = ranging_compensate(ranging_median(range_mm, CONFIG_UDP_ALARM_FRAMES), temp_factor_q16);
+	cause = alarm_evaluate(&alarm_status, distance, k_uptime_get());
+	printk("Alarm sensing %dmm cause %d\n", distance, cause);
+	power_put(POWER_UART); //UART~
+
+	//x񎞂͒M҂ɑM
+	if (cause != ALARM_NONE) {
+		alarm_pending = cause;
+		k_work_reschedule(&server_transmission_work, K_NO_WAIT);
+	}
+	k_work_schedule(&alarm_sensing_work, K_SECONDS(CONFIG_UDP_ALARM_SENSING_SECONDS));
+}
+#endif
+
+//̑M܂ł̑҂ms
+//Mʒu̓T[ow̃XbgAȂICCID狁߂ʒu ([ƂɑMŕU)
+//v擾łȂꍇ͋NoߎԂő (Ñ_҂ŕUς)
+static uint32_t next_transmission_ms(const char *iccid)
+{
+	uint32_t phase_ms;
+	int64_t now_ms = k_uptime_get();
+
+	if (server_slot_ms != SCHEDULE_NO_SLOT) {
+		phase_ms = server_slot_ms;
+	} else {
+		phase_ms = schedule_phase_ms(iccid, PERIOD_MS);
+	}
+	if (wall_valid) {
+		now_ms += wall_offset_ms;
+	}
+
+	//Mʒu̕ύX (SLOTwEv̎擾) MԊu͎1/2ȏ゠
+	//҂Ԃ͍ŒőM1.5{ (WDT_WINDOW_MS͏Ԃ܂߂Ă)
+	return schedule_next_ms(now_ms, phase_ms, PERIOD_MS, NEXT_MIN_MS);
+}
+
+#if defined(CONFIG_UDP_FOTA_ENABLE)
+static bool fota_requested; //T[oFOTAv (̎FOTAT[oɖ₢킹)
+#endif
+
+//T[õ_EN (MCONFIG_UDP_DOWNLINK_WAIT_MSEC҂)
+//[SLOT,<b>] Mʒu̎w (-1ŉ)  [TRACE] ۑς݃g[X̗v  [FOTA] XVC[W̖₢킹v
+static void downlink_poll(int fd)
+{
+	struct timeval timeout = {
+		.tv_sec = CONFIG_UDP_DOWNLINK_WAIT_MSEC / 1000,
+		.tv_usec = (CONFIG_UDP_DOWNLINK_WAIT_MSEC % 1000) * 1000,
+	};
+	char req[16];
+	int len, a, slot_s;
+
+	if (CONFIG_UDP_DOWNLINK_WAIT_MSEC == 0) {
+		return;
+	}
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	for (a = 0; a < 2; a++) {
+		len = recv(fd, req, sizeof(req) - 1, 0);
+		if (len <= 0) {
+			break;
+		}
+		req[len] = '\0';
+		printk("Downlink [%s]\n", req);
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+		dtls_silent_uplinks = 0; //Mł̂DTLSZbV͗L
+#endif
+		if (sscanf(req, "SLOT,%d", &slot_s) == 1) {
+			if (slot_s < 0) {
+				server_slot_ms = SCHEDULE_NO_SLOT;
+			} else {
+				server_slot_ms = (uint32_t)slot_s % CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS * 1000;
+			}
+		} else if (strcmp(req, "TRACE") == 0) {
+			trace_send(fd);
+#if defined(CONFIG_UDP_FOTA_ENABLE)
+		} else if (strcmp(req, "FOTA") == 0) {
+			fota_requested = true;
+#endif
+		}
+	}
+}
+
+static struct defer_state defer_status __attribute__((section(".noinit.defer"))); //dg󋵂ɂ鑗M̏
+
 //UDPf[^Mt@NV
 uint32_t countUDPsend = 1;
 static void server_transmission_work_fn(struct k_work *work)
@@ -401,148 +770,52 @@ static void server_transmission_work_fn(struct k_work *work)
 	char request_iccid[32] = {0};
 	char request_cclk[21] = {0};
 	char request_cops[15] = {0};
-	int countTimeout = 0;
-	char rx_byte;
-	char data_wls[13][20] = {{0},{0}};
+	int16_t range_mm[RANGING_FRAME_COUNT] = {0};
+	int16_t corrected_mm[RANGING_FRAME_COUNT];
+	int16_t distance_mm;
+	int temp_abs;
 	int countRetry = 0;
-	int a,i = 0;
-	char ResponseData[17][12];
-	char *ResponsePt;
-
-	char request_plmn[8] = {0};
-	char request_tac[7] = {0};
-	char request_band[3] = {0};
-	char request_cell_id[11] = {0};
-	char request_es[2] = {0};
-	char request_rsrp[4] = {0};
-	char request_rsrq[4] = {0};
-	char request_snr[4] = {0};
-	char setMB7388 = 0;
-	char setMB7051 = 0;
-	char setSensor10Meter = 0;
-
-	uart0_set_enable(true); //UARTL
+	int i = 0;
+	struct xmonitor_info xmonitor;
+	struct coneval_info coneval;
+	const struct ranging_sensor *sensor;
+	enum alarm_cause cause = ALARM_NONE;
+	enum defer_decision decision;
+	int len;
+
+	console_set_enable(true); //R\[o͗L
+	profile_begin(PROFILE_CYCLE);
 
 	printk("\n\n************************************************\n");
 	printk("Start of measurement and transmission. No.%d\n", countUDPsend);
 
-	printk("DIP-SW status [%d:%d:%d:%d]\n",gpio_pin_get_dt(&SW0),gpio_pin_get_dt(&SW1),gpio_pin_get_dt(&SW2),gpio_pin_get_dt(&SW3));
+	//ZT[^Cv (Kconfig ܂DIPXCb` 2ԁE3)
+	sensor = sensor_select();
+	printk("Range Finder %s\n", sensor->name);
+	trace_begin(sensor->name);
 
-	//DIPXCb` 2 ZT[^Cv
-	// ONFV[g^CvMB7388(10m)
-	//OFFFV[g^CvMB7389(5m)
-	if(gpio_pin_get_dt(&SW2) == 1) {
-		setMB7388 = 1; //MB7388(10m)
-	} else {
-		setMB7388 = 0; //MB7389(5m)
-	}
-
-	//DIPXCb` 3 ZT[^Cv
-	// ONFO^CvMB7051(10m)
-	//OFFFV[g^CvMB7389(5m)
-	if(gpio_pin_get_dt(&SW3) == 1) {
-		setMB7051 = 1; //MB7051(10m)
-	} else {
-		setMB7051 = 0; //MB7389(5m)
-	}
+	//xϊJn (gZT[̌vƕsĕϊ)
+	measure_temp_start();
 
-	//ZT[Zbg
-	if(gpio_pin_get_dt(&SW2) == 0 && gpio_pin_get_dt(&SW3) == 0) {
-		setSensor10Meter = 0; //5mZT[
-	} else {
-		setSensor10Meter = 1; //10mZT[
-	}
-
-	//gZT[f[^擾
+	//gZT[f[^擾
+	power_get(POWER_UART); //UARTL
 	gpio_pin_set_dt(&WS_POWER, 1); //ZT[dON
 	gpio_pin_set_dt(&WA_START, 1); //ZT[vX^[g
-	k_msleep(170); //NbZ[W҂
+	k_msleep(170); //NbZ[WM҂
+	profile_begin(PROFILE_RANGE);
 	do {
 		printk("Ultrasonic Range Finder Sensing Try.%d\n", countRetry + 1);
-		//z񏉊
-		for(a = 0; a < 13; a++) {
-			for (i = 0; i < 20; i++) {
-				data_wls[a][i] = 0;
-			}
-		}
-		//UARTM
-		for(a = 0; a < 13; a++) {
-			i = 0;
-			rx_byte = 0;
-			countTimeout = 0;
-			//ŏIMsR[hꍇ͎̔z(s)Ɉڂ
-			while (rx_byte != 13) {
-				err = uart_poll_in(uart_dev, &rx_byte); //UARTMf[^1ǂݍ݁B󂾂ꍇ͑҂B
-				if (err != -1) {
-					countTimeout = 0;
-					if (rx_byte != 'R' && rx_byte != 13) {
-						data_wls[a][i] = rx_byte; //UARTMf[^'R'͉sR[hłȂ1i[
-						i++;
-					}
-				} else {
-					countTimeout++;     //UART̃f[^󂾂ꍇ̓JEgAbv
-					k_msleep(1); //1msX[v
-				}
-				//^CAEg 1bȓUARTMłȂꍇ̓^CAEg
-				if (countTimeout > UART_TIMEOUT_MSEC) {
-					printk("*** Range Finder Timeout\n");
-					break;
-				}
-			}
-			//^CAEg͔z-999ăuCN
-			if (countTimeout > UART_TIMEOUT_MSEC) {
-				for (a = 0; a < 13; a++) {
-					sprintf(data_wls[a], "-999");
-				}
-				break;
-			}
-		}
-		//^CAEg̓uCN
-		if (countTimeout > UART_TIMEOUT_MSEC) {
+		//UARTM ^CAEg̓uCN
+		if (range_finder_read(sensor, range_mm, RANGING_FRAME_COUNT) != 0) {
 			break;
 		}
 		//fobOp
-		for (a = 8; a < 13; a++) {
-			printk("DATA [%02d] %.4s\n", a, data_wls[a]);
-		}
-		//ZT[O^CvMB7051(10m)̏ꍇ͒l10{cmmmɂ鏈
-		if (setMB7051 == 1 && atoi(data_wls[0]) != -999) {
-			for (a = 8; a < 13; a++) {
-				if (atoi(data_wls[a]) > 999) {
-					sprintf(data_wls[a],"9999"); //999cm(9990mmȏ̂Ƃ̓G[lɒu
-				} else {
-					sprintf(data_wls[a],"%d", atoi(data_wls[a]) * 10);
-				}
-				//printk("MB7051 String %s\n", data_wls[a]);
-			}
-		}
-		//vlG[
-		//G[̏ꍇ-1Zbg
-		//z8,9,10,11,12vlƂč̗p
-		//5mZT[̃W 300`4999mm (ˏ̏ꍇ5000mm)
-		//10mZT[̃W 500`9998mm (ˏ̏ꍇ9999mm)
-		if (atoi(data_wls[0]) != -999) {
-			for (a = 8; a < 13; a++) {
-				//5mZT[
-				if (setSensor10Meter == 0 && (atoi(data_wls[a]) < 300 || atoi(data_wls[a]) > 4999)) {
-					printk("Sensing ERROR [%d] = %s\n", a-7, data_wls[a]);
-					sprintf(data_wls[a], "-1"); //5mZT[300mm4999mmȏ̓G[(os5000mm)
-				}
-				//10mZT[
-				if (setSensor10Meter == 1 && (atoi(data_wls[a]) < 500 || atoi(data_wls[a]) > 9998)) {
-					printk("Sensing ERROR [%d] = %s\n", a-7, data_wls[a]);
-					sprintf(data_wls[a], "-1"); //10mZT[500mm9998mmȏ̓G[(os9999mm)
-				}
-			}
-		}
-		//vlG[JEg
-		err = 0;
-		for (a = 8; a < 13; a++) {
-			//printk("Sensing Data No[%d] = %s\n", a-7, data_wls[a]);
-			if (atoi(data_wls[a]) < 0) {
-				err++;
-			}
+		for (i = 0; i < RANGING_FRAME_COUNT; i++) {
+			printk("DATA [%02d] %d\n", i + sensor->warmup_frames, range_mm[i]);
 		}
+		//vlG[JEg
+		err = ranging_error_count(range_mm, RANGING_FRAME_COUNT);
+		trace_event(TRACE_EV_SENSING, err);
 		//G[\
 		printk("Sensing error count %d\n", err);
 		if (err >= 3) {
@@ -557,174 +830,267 @@ static void server_transmission_work_fn(struct k_work *work)
 			break;
 		}
 	} while (err >= 3); //3ȏ̃G[ŃgCBŒ3̌vl𓾂B
+	profile_end(PROFILE_RANGE);
+	trace_event(TRACE_EV_RETRY, countRetry - 1);
 
 	//gZT[dOFF
 	gpio_pin_set_dt(&WA_START, 0); //ZT[v~
 	gpio_pin_set_dt(&WS_POWER, 0); //ZT[dOFF
+	power_put(POWER_UART); //UART~
+
+	//x擾 (ϊ͌vɊĂ)
+	profile_begin(PROFILE_TEMP);
+	int16_t value_temp = measure_temp();
+	profile_end(PROFILE_TEMP);
+
+	//vl̉x␳ƕ␳̋ (l苗ȓ̕)
+	temp_factor_update(sensor, value_temp);
+	for (i = 0; i < RANGING_FRAME_COUNT; i++) {
+		corrected_mm[i] = ranging_compensate(range_mm[i], temp_factor_q16);
+	}
+	distance_mm = ranging_reliable(corrected_mm, RANGING_FRAME_COUNT);
+	printk("Temperature %d/16C factor %u/65536 distance %dmm\n", value_temp, temp_factor_q16, distance_mm);
+
+#if defined(CONFIG_UDP_ALARM_ENABLE)
+	//x񔻒 ȈՌvŌmxD
+	cause = alarm_evaluate(&alarm_status, ranging_median(corrected_mm, RANGING_FRAME_COUNT), k_uptime_get());
+	if (alarm_pending != ALARM_NONE) {
+		cause = alarm_pending;
+		alarm_pending = ALARM_NONE;
+	}
+	printk("Alarm cause %d\n", cause);
+	trace_event(TRACE_EV_ALARM, cause);
+#endif
 
 	//XMONITOR擾
 	// [AT%XMONITOR=5,"KDDI","KDDI","44051","185C",7,18,"008AAA5C",316,5900,44,22,"1010","00000000","00100111","01011111"]
 	memset(buffer, '\0', sizeof(buffer));
+	profile_begin(PROFILE_AT_XMONITOR);
 	nrf_modem_at_scanf("AT%XMONITOR","%%XMONITOR: %120[ ,-\"a-zA-Z0-9]", buffer);
+	profile_end(PROFILE_AT_XMONITOR);
 	printk("AT%%XMONITOR=%s\n",buffer);
-	ResponsePt = strtok(buffer,",");
-	sprintf(ResponseData[0], "%s", ResponsePt);
-	a = 1;
-	while (ResponsePt != NULL)
-	{
-		ResponsePt = strtok(NULL,",");
-		if(ResponsePt == NULL) {break;}
-		sprintf(ResponseData[a], "%s", ResponsePt);
-		a++;
-		if(a >= 17) {break;}
-	}
-	//XMONITOR擾
-	if (strcmp(ResponseData[0],"0") == 5) {
-		sprintf(request_plmn   , "%.7s" , ResponseData[3]); // PLMN ["44020"]
-		sprintf(request_tac    , "%.6s" , ResponseData[4]); // TACR[h ["185C"]
-		sprintf(request_band   , "%.2s" , ResponseData[6]); // ohԍ [18]
-		sprintf(request_cell_id, "%.10s", ResponseData[7]); // CELL ID ["008AAA5C"]
-	} else {
-		printk("AT%%XMONITOR ERROR\n");            // Xe[^X擾s
-		sprintf(request_plmn   ,   "\"00000\"" );  // PLMN G[l
-		sprintf(request_tac    ,    "\"0000\"" );  // TACR[h G[l
-		sprintf(request_band   ,           "0" );  // ohԍ G[l
-		sprintf(request_cell_id, "\"00000000\"");  // CELL ID G[l
-	}
-	printk("plmn   : %s\n", request_plmn   );
-	printk("tac    : %s\n", request_tac    );
-	printk("band   : %s\n", request_band   );
-	printk("cell_id: %s\n", request_cell_id);
+	trace_at("AT%XMONITOR", buffer);
+	profile_begin(PROFILE_PARSE_XMONITOR);
+	if (!at_parse_xmonitor(buffer, &xmonitor)) {
+		printk("AT%%XMONITOR ERROR\n"); // Xe[^X擾s
+		trace_event(TRACE_EV_XMONITOR_ERROR, 0);
+	}
+	profile_end(PROFILE_PARSE_XMONITOR);
+	printk("plmn   : %s\n", xmonitor.plmn);
+	printk("tac    : %s\n", xmonitor.tac);
+	printk("band   : %s\n", xmonitor.band);
+	printk("cell_id: %s\n", xmonitor.cell_id);
 
 	//CONEVAL擾
 	// [AT%CONEVAL=0,0,6,42,3,17,"008AAA5C","44051",331,5900,18,0,0,4,2,8,117]
 	memset(buffer, '\0', sizeof(buffer));
+	profile_begin(PROFILE_AT_CONEVAL);
 	nrf_modem_at_scanf("AT%CONEVAL","%%CONEVAL: %120[ ,-\"a-zA-Z0-9]", buffer);
+	profile_end(PROFILE_AT_CONEVAL);
 	printk("AT%%CONEVAL=%s\n",buffer);
-	ResponsePt = strtok(buffer,",");
-	sprintf(ResponseData[0], "%s", ResponsePt);
-	a = 1;
-	while (ResponsePt != NULL)
-	{
-		ResponsePt = strtok(NULL,",");
-		if(ResponsePt == NULL) {break;}
-		sprintf(ResponseData[a], "%s", ResponsePt);
-		a++;
-		if(a >= 17) {break;}
-	}
-	//CONEVAL擾
-	if (strcmp(ResponseData[0],"0") == 0) {
-		sprintf(request_es  , "%.1s", ResponseData[2]); // d͌ 6
-		sprintf(request_rsrp, "%.3s", ResponseData[3]); // MMd -17
-		sprintf(request_rsrq, "%.3s", ResponseData[4]); // MMi -30
-		sprintf(request_snr , "%.3s", ResponseData[5]); // MmCY 49
-	} else {
-		printk("AT%%CONEVAL ERROR\n");// Xe[^X擾s
-		sprintf(request_es  , "0");   // d͌ G[l
-		sprintf(request_rsrp, "255"); // MMd G[l
-		sprintf(request_rsrq, "255"); // MMi G[l
-		sprintf(request_snr , "127"); // MmCY G[l
-	}
-	printk("es   : %s\n", request_es  );
-	printk("rsrp : %s\n", request_rsrp);
-	printk("rsrq : %s\n", request_rsrq);
-	printk("snr  : %s\n", request_snr );
+	trace_at("AT%CONEVAL", buffer);
+	profile_begin(PROFILE_PARSE_CONEVAL);
+	if (!at_parse_coneval(buffer, &coneval)) {
+		printk("AT%%CONEVAL ERROR\n"); // Xe[^X擾s
+		trace_event(TRACE_EV_CONEVAL_ERROR, 0);
+	}
+	profile_end(PROFILE_PARSE_CONEVAL);
+	printk("es   : %s\n", coneval.es  );
+	printk("rsrp : %s\n", coneval.rsrp);
+	printk("rsrq : %s\n", coneval.rsrq);
+	printk("snr  : %s\n", coneval.snr );
 
 	//擾  [+CCLK: "18/12/06,22:10:00+08"]
+	profile_begin(PROFILE_AT_INFO);
 	err = nrf_modem_at_scanf("AT+CCLK?","+CCLK: \"%20[,:+/0-9]\"", request_cclk);
+	profile_end(PROFILE_AT_INFO);
 	printk("AT+CCLK=%s\n",request_cclk);
+	trace_at("AT+CCLK?", request_cclk);
 	if (err != 1){
 		sprintf(request_cclk, "-1,-1");
+	} else if (schedule_cclk_to_s(request_cclk) >= 0) {
+		wall_offset_ms = schedule_cclk_to_s(request_cclk) * 1000 - k_uptime_get();
+		wall_valid = true;
 	}
 
 	//ICCID擾
+	profile_begin(PROFILE_AT_INFO);
 	err = nrf_modem_at_scanf("AT%XICCID","%%XICCID: ""%20[0-9]", request_iccid);
+	profile_end(PROFILE_AT_INFO);
 	printk("AT%%XICCID=%s\n",request_iccid);
 	if (err != 1) {
 		sprintf(request_iccid, "-1");
 	}
 
+	profile_begin(PROFILE_ADC);
 	int16_t value_battmv = measure_batt_mv(); //dd擾
-	float value_temp = measure_temp();        //x擾
+	profile_end(PROFILE_ADC);
+	temp_abs = (abs(value_temp) * 100 + 8) / 16; //x 1/100P (Ȃ)
 
 	//M񐶐
+	profile_begin(PROFILE_FORMAT);
 	memset(buffer, '\0', sizeof(buffer));
-	sprintf(buffer, "%.20s,%.19s,%04d,%+06.2f,%.4s,%.4s,%.4s,%.4s,%.4s,%010d,%.2s,%.7s,%.6s,%.10s,%.1s,%.3s,%.3s,%.3s,%1d,%02d",
+	len = sprintf(buffer, PAYLOAD_FORMAT,
 	                request_cclk,     // (20)
 	                request_iccid,    //ICCID (19)
 	                value_battmv,     //dd
-	                value_temp,       //x
-	                data_wls[ 8],     //g1 (4)
-	                data_wls[ 9],     //g2 (4)
-	                data_wls[10],     //g3 (4)
-	                data_wls[11],     //g4 (4)
-	                data_wls[12],     //g5 (4)
+	                value_temp < 0 ? '-' : '+', temp_abs / 100, temp_abs % 100, //x (_ȉ2)
+	                range_mm[0],      //g1 (4)
+	                range_mm[1],      //g2 (4)
+	                range_mm[2],      //g3 (4)
+	                range_mm[3],      //g4 (4)
+	                range_mm[4],      //g5 (4)
 	                countUDPsend,     //M
-	                request_band   ,  //ohԍ (2)
-	                request_plmn   ,  //PLMNԍ (7)
-	                request_tac    ,  //TACR[h (6)
-	                request_cell_id,  //ZID (10)
-	                request_es     ,  //GlM[ (1)
-	                request_rsrp   ,  //RSRP Md (3)
-	                request_rsrq   ,  //RSRQ M\d (3)
-	                request_snr    ,  //SNR  MmCY (3)
-	                setSensor10Meter, //gZT[(0:5m/1:10m)
-	                countRetry - 1    //胊gC
+	                xmonitor.band,    //ohԍ (2)
+	                xmonitor.plmn,    //PLMNԍ (7)
+	                xmonitor.tac,     //TACR[h (6)
+	                xmonitor.cell_id, //ZID (10)
+	                coneval.es     ,  //GlM[ (1)
+	                coneval.rsrp   ,  //RSRP Md (3)
+	                coneval.rsrq   ,  //RSRQ M\d (3)
+	                coneval.snr    ,  //SNR  MmCY (3)
+	                sensor->range_code, //gZT[(0:5m/1:10m)
+	                countRetry - 1,   //胊gC
+	                cause,            //xv(0:/1:/2:㏸x)
+	                link_recovery_count[LINK_RECOVERY_SOCKET],   //N񕜉 \Pbgč쐬
+	                link_recovery_count[LINK_RECOVERY_REG_WAIT], //N񕜉 o^҂
+	                link_recovery_count[LINK_RECOVERY_CFUN],     //N񕜉 CFUN؂ւ
+	                link_recovery_count[LINK_RECOVERY_RESET],    //N񕜉 VXeZbg
+	                seqno_boot_count(), //N
+	                seqno_next()        //V[PXԍ (ZbgEdf܂ŒP)
 	                );
+	//ffp̗ (CONFIG_UDP_PAYLOAD_EXTENDED=n̏ꍇ28̂)
+	if (IS_ENABLED(CONFIG_UDP_PAYLOAD_EXTENDED)) {
+		sprintf(buffer + len, PAYLOAD_FORMAT_EXTENDED,
+		        defer_status.deferred, //M
+		        defer_status.forced,   //dg󋵂Ɋւ炸M (xE)
+		        defer_status.saved,    //ߖd͗ (GlM[l9̑M110ƂΒl)
+		        distance_mm       //x␳̋ (l苗ȓ̕ vG[:-1)
+		        );
+	}
+	profile_end(PROFILE_FORMAT);
 	printk("UDP send data [%s]\n", buffer);
 	printk("Transmitting UDP/IP payload of %d bytes to the ", strlen(buffer) + UDP_IP_HEADER_SIZE);
-	printk("IP address %s, port number %d\n", CONFIG_UDP_SERVER_ADDRESS_STATIC, CONFIG_UDP_SERVER_PORT);
+	printk("IP address %s, port number %d\n", CONFIG_UDP_SERVER_ADDRESS_STATIC, SERVER_PORT);
 	printk("WDT call count %d\n", WDT_call_count);
-	err = send(client_fd, buffer, strlen(buffer), 0); //UDPMs
-
-	//UDPM̃fbhbNoO
-	if (err < 0) {
-		printk("Failed to transmit UDP packet, %d\n", errno);
+	uplink_queue_push(buffer); //Mf[^ɒǉ
+
+	//dg󋵂ꍇA}łȂf[^͖Mf[^ɎcĎ̎ōĔ
+	decision = defer_evaluate(&defer_status, atoi(coneval.es), atoi(coneval.rsrp) - 140, cause != ALARM_NONE,
+	                          uplink_queue_count() >= UPLINK_QUEUE_LEN, k_uptime_get());
+	if (decision == DEFER_HOLD) {
+		printk("Transmission deferred (ES %s RSRP %s), %d payloads queued\n", coneval.es, coneval.rsrp,
+		       uplink_queue_count());
+		trace_event(TRACE_EV_DEFER, atoi(coneval.es));
+		countUDPsend++; //f[^M񐔂ɐ (̃f[^ƓԍɂȂ)
+		wdt_feed(wdt_dev, wdt_main_channel); //WDTZbg
+		trace_end();
+		profile_end(PROFILE_CYCLE);
+		profile_report();
+		printk("************************************************\n\n");
+		console_set_enable(false); //R\[o͒~
+		k_work_schedule(&server_transmission_work, K_MSEC(next_transmission_ms(request_iccid)));
+		return;
+	}
+	if (decision != DEFER_SEND) {
+		trace_event(TRACE_EV_DEFER, -decision);
+	}
 
-		//đMsBłG[oꍇ̓VXeZbg
-		printk("Resend UDP packet\n");
-		server_disconnect();    //T[oؒf
-		err = server_connect(); //T[oڑ
-		if (err) {
-			printk("Not able to connect to UDP server\n"); //UDPT[oڑG[
-		} else {
-			printk("UDP server connected\n"); //UDPT[oڑ
-		}
-		err = send(client_fd, buffer, strlen(buffer), 0); //UDPMs
-		if (err < 0) {
-			printk("Failed to transmit UDP packet, %d\n", errno); //UDPMG[
-			NVIC_SystemReset(); //VXeZbg
-		} else {
-			printk("Resend Success UDP packet, %d\n", errno); //UDPđM
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+	//DTLS ZbV؂͑MG[ɂȂȂ߁A_EN̂Ȃ܂ܑꍇ̓\Pbg蒼
+	//(ZbVLbVɂZknhVFCNōĊJ)
+	if (dtls_silent_uplinks >= CONFIG_UDP_DTLS_RECONNECT_UPLINKS) {
+		printk("DTLS reconnect after %d uplinks without downlink\n", dtls_silent_uplinks);
+		server_disconnect();
+		if (server_connect() != 0) {
+			printk("Not able to connect to UDP server\n"); //M̃N񕜂ɔC
 		}
-	} else {
-		printk("Success to transmit UDP packet, %d\n", errno);
 	}
+	dtls_silent_uplinks++;
+#endif
+	profile_begin(PROFILE_SEND);
+	err = uplink_flush(); //Mf[^ÂɑM
+	profile_end(PROFILE_SEND);
 
 	//COPS擾 [+COPS: 0,2,"44020",7]
-	//nǂւ̐ڑmFłȂꍇ̓VXeZbg
+	//nǂւ̐ڑmFłȂꍇ͓o^҂ECFUN؂ւŉ񕜂݂
 	nrf_modem_at_scanf("AT+COPS?","+COPS: %14[,\"0-9]", request_cops);
 	printk("AT+COPS=%s\n",request_cops);
+	trace_at("AT+COPS?", request_cops);
 	if (strcmp(request_cops,"1") == 0 )
 	{
 		printk("CONNECTION ERROR\n");
-		NVIC_SystemReset(); //VXeZbg
+		if (link_recover(LINK_RECOVERY_REG_WAIT) != 0 && link_recover(LINK_RECOVERY_CFUN) != 0) {
+			err = -ENOTCONN;
+		} else if (err != 0) {
+			err = uplink_flush(); //񕜂ł̂őMłȂMf[^đ
+		}
 	}
 
-	//MWDTZbg
+	//MWDTZbg (񕜏ŎɎ܂ȂꍇZbg)
 	wdt_feed(wdt_dev, wdt_main_channel); //WDTZbg
+
+	if (err) {
+		//Ms Mf[^͎񑗐Mɍđ
+		link_fail_cycles++;
+		printk("Transmission failed %d times, %d payloads queued\n", link_fail_cycles, uplink_queue_count());
+		trace_end(); //ُ̂̃g[Xۑ
+		if (link_fail_cycles >= CONFIG_UDP_LINK_RESET_CYCLES) {
+			link_recover(LINK_RECOVERY_RESET); //ŏIiƂăVXeZbg
+		}
+		profile_end(PROFILE_CYCLE);
+		profile_report();
+		printk("************************************************\n\n");
+		console_set_enable(false); //R\[o͒~
+		//Ԋu΂ȂĎs (QŎ~܂[ɍĎsȂ悤Wb^)
+		k_work_schedule(&server_transmission_work,
+		                K_MSEC(MIN(schedule_jitter_ms((CONFIG_UDP_LINK_RETRY_SECONDS << (link_fail_cycles - 1)) * 1000,
+		                                              sys_rand32_get()),
+		                           PERIOD_MS)));
+		return;
+	}
+	link_fail_cycles = 0;
 	WDT_call_count = 0;
+	defer_sent(&defer_status, atoi(coneval.es)); //Ăf[^̐ߖʂWv
+
+	trace_end();              //ُ̂̃g[Xۑ
+	downlink_poll(client_fd); //T[ȏMʒuwEg[XvEFOTAvɉ
+
+#if defined(CONFIG_UDP_FOTA_ENABLE)
+	fota_confirm_image(); //MŋNC[Wm
+
+	//FOTA T[ovꍇƃ_E[hȑꍇ̂݁Adrd臒lȏŎs
+	//MWDT̔̎Ԃőł؂AIWDTZbgĎ̎̎Ԃmۂ
+	if (fota_requested || fota_in_progress()) {
+		fota_requested = false;
+		if (value_battmv >= CONFIG_UDP_FOTA_MIN_BATT_MV && strcmp(request_iccid, "-1") != 0) {
+			wdt_feed(wdt_dev, wdt_main_channel); //WDTZbg
+			if (fota_process(request_iccid, WDT_WINDOW_MS / 2) == 1) {
+				printk("Reboot for firmware update\n");
+				NVIC_SystemReset(); //VXeZbg(MCUbootŃC[Wւ)
+			}
+			wdt_feed(wdt_dev, wdt_main_channel); //WDTZbg
+		} else {
+			printk("FOTA skipped (battery %dmV)\n", value_battmv);
+		}
+	}
+#endif
 
 	countUDPsend++; //AM񐔃JEg
+	profile_end(PROFILE_CYCLE);
+	profile_report();
 	printk("************************************************\n\n");
-	uart0_set_enable(false); //UART~
-	k_work_schedule(&server_transmission_work, K_SECONDS(CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS)); //UDPMXPW[ɒǉ
+	console_set_enable(false); //R\[o͒~
+	k_work_schedule(&server_transmission_work, K_MSEC(next_transmission_ms(request_iccid))); //UDPMXPW[ɒǉ
 }
 
 //MXbh
 static void work_init(void)
 {
 	k_work_init_delayable(&server_transmission_work, server_transmission_work_fn);
+#if defined(CONFIG_UDP_ALARM_ENABLE)
+	k_work_init_delayable(&alarm_sensing_work, alarm_sensing_work_fn);
+#endif
 	printk("work_init done.\n");
 }
 
@@ -735,9 +1101,12 @@ static void lte_handler(const struct lte_lc_evt *const evt)
 	case LTE_LC_EVT_NW_REG_STATUS:
 		if ((evt->nw_reg_status != LTE_LC_NW_REG_REGISTERED_HOME) &&
 		     (evt->nw_reg_status != LTE_LC_NW_REG_REGISTERED_ROAMING)) {
+			lte_registered = false;
 			break;
 		}
 
+		lte_registered = true;
+
 		printk("Network registration status: %s\n",evt->nw_reg_status == LTE_LC_NW_REG_REGISTERED_HOME ? "Connected - home network" : "Connected - roaming\n");
 		k_sem_give(&lte_connected);
 		break;
@@ -779,36 +1148,63 @@ static void modem_init(void)
 		return;
 	}
 
-	//Power Saving Mode Enable
-	err = lte_lc_psm_req(true);
-	if (err) {
-		printk("lte_lc_psm_req, error: %d\n", err);
+	//PSMEeDRX̗vlmodem_connectKconfig̒lZbg
+	//̏ꍇ͗v
+	if (!IS_ENABLED(CONFIG_UDP_PSM_ENABLE)) {
+		err = lte_lc_psm_req(false);
+		if (err) {
+			printk("lte_lc_psm_req, error: %d\n", err);
+		}
 	}
-
-	//Enhanced Discontinuous Reception Enable
-	/* eDRXgpɃRgAEg
-	err = lte_lc_edrx_req(true);
-	if (err) {
-		printk("lte_lc_edrx_req, error: %d\n", err);
+	if (!IS_ENABLED(CONFIG_UDP_EDRX_ENABLE)) {
+		err = lte_lc_edrx_req(false);
+		if (err) {
+			printk("lte_lc_edrx_req, error: %d\n", err);
+		}
 	}
 
 	//Release Assistance Indication Enable
-	err = lte_lc_rai_req(true);
-	if (err) {
-		printk("lte_lc_rai_req, error: %d\n", err);
+	if (IS_ENABLED(CONFIG_UDP_RAI_ENABLE)) {
+		err = lte_lc_rai_req(true);
+		if (err) {
+			printk("lte_lc_rai_req, error: %d\n", err);
+		}
 	}
-	*/
-
 }
 
 volatile uint8_t first_boot __attribute__((section(".noinit.boot")));   //NtO(ΏۊOϐ̒`)
 volatile uint8_t startup_PLMN __attribute__((section(".noinit.plmn"))); //LTEڑϐ(ΏۊOϐ̒`)
 
+//ڑLA (startup_PLMN̏ACONFIG_UDP_CARRIER_INDEX͏N̐ڑ)
+static const struct {
+	const char *name;
+	const char *cops; //PLMNZbgATR}h
+} carriers[] = {
+	{ "SoftBank", "AT+COPS=1,2,\"44020\"" },
+	{ "docomo", "AT+COPS=1,2,\"44010\"" },
+	{ "KDDI", "AT+COPS=1,2,\"44051\"" },
+};
+
+//N̐ڑLA
+//DIPXCb` 0ԁE1Ԃ̂ǂ炩ON̏ꍇDIPXCb`ɏ] (CONFIG_UDP_DIP_OVERRIDE)
+static uint8_t carrier_select(void)
+{
+	if (IS_ENABLED(CONFIG_UDP_DIP_OVERRIDE) && (dip_sw[0] || dip_sw[1])) {
+		if (dip_sw[0] == 1 && dip_sw[1] == 0) {
+			return 1; //hR
+		}
+		if (dip_sw[0] == 0 && dip_sw[1] == 1) {
+			return 2; //KDDI
+		}
+		return 0; //\tgoN (ON)
+	}
+	return CONFIG_UDP_CARRIER_INDEX;
+}
+
 //LTEڑ葱ATR}hQ
 static int modem_connect(void)
 {
     int err = 0;
-    char setPLMN[32] = {0};
 
 	//ATR}hmF
 	printk("AT\n");
@@ -821,8 +1217,8 @@ static int modem_connect(void)
 
 	//APNݒ
 	printk("\nAPN setting\n");
-	printk("AT+CGDCONT=1,%s,%s\n","\"IP\"","\"sakura\"");
-	err = nrf_modem_at_printf("AT+CGDCONT=1,%s,%s\n","\"IP\"","\"sakura\"");
+	printk("AT+CGDCONT=1,\"IP\",\"%s\"\n", CONFIG_UDP_APN);
+	err = nrf_modem_at_printf("AT+CGDCONT=1,\"IP\",\"%s\"", CONFIG_UDP_APN);
 	if (err) {
 		printk(" *** AT+CGDCONT failed\n");
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
@@ -847,46 +1243,27 @@ static int modem_connect(void)
 	}
 
 	//ڑLAݒ PLMNZbg
-	//NDIPXCb`ɏ] (first_boot != 0xAA)
-	//2ڈȍ~͑O̐ڑLA̎̃LAZbg
+	//NKconfig (CONFIG_UDP_CARRIER_*) ܂DIPXCb`ɏ] (first_boot != 0xAA)
+	//2ڈȍ~͑O̐ڑLA̎̃LAZbg (CONFIG_UDP_CARRIER_FALLBACK)
 	//\tgoNhRKDDȈɎs
 	printk("\nPLMN setting\n");
 	if (first_boot != 0xAA) {
 		first_boot = 0xAA;
-		//N (DIPXCb`ŃZbg)
-		if(gpio_pin_get_dt(&SW0) == 0 && gpio_pin_get_dt(&SW1) == 0) {
-			startup_PLMN = 0; //\tgoN
-		}
-		else if (gpio_pin_get_dt(&SW0) == 1 && gpio_pin_get_dt(&SW1) == 0) {
-			startup_PLMN = 1; //hR
-		}
-		else if (gpio_pin_get_dt(&SW0) == 0 && gpio_pin_get_dt(&SW1) == 1) {
-			startup_PLMN = 2; //KDDI
-		}
-		else {
-			startup_PLMN = 0; //\tgoN
-		}
-	} else {
+		startup_PLMN = carrier_select();
+	} else if (IS_ENABLED(CONFIG_UDP_CARRIER_FALLBACK)) {
 		//2ڈȍ~ (Đڑs5ڂŎPLMNɈڂ)
 		if (WDT_call_count >= 5) {
 			WDT_call_count = 0;
-			if (startup_PLMN >= 2) {
-				startup_PLMN = 0;
-			} else {
-				startup_PLMN++;
-			}
+			startup_PLMN++;
 		}
 	}
-	//PLMN̐ݒ
-	switch (startup_PLMN) {
-		case 0: sprintf(setPLMN, "AT+COPS=1,2,%s\n","\"44020\""); printk("carrier select SoftBank\n");break;
-		case 1: sprintf(setPLMN, "AT+COPS=1,2,%s\n","\"44010\""); printk("carrier select docomo\n");break;
-		case 2: sprintf(setPLMN, "AT+COPS=1,2,%s\n","\"44051\""); printk("carrier select KDDI\n");break;
-		default:sprintf(setPLMN, "AT+COPS=1,2,%s\n","\"44020\""); printk("carrier select SoftBank\n");break;
+	if (startup_PLMN >= ARRAY_SIZE(carriers)) {
+		startup_PLMN = 0;
 	}
+	printk("carrier select %s\n", carriers[startup_PLMN].name);
 
-	printk("%s", setPLMN);
-	err = nrf_modem_at_printf("%s", setPLMN);
+	printk("%s\n", carriers[startup_PLMN].cops);
+	err = nrf_modem_at_printf("%s", carriers[startup_PLMN].cops);
 	if (err) {
 		printk(" *** AT+COPS failed\n");
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
@@ -919,35 +1296,39 @@ static int modem_connect(void)
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
 	}
 
+#if defined(CONFIG_UDP_PSM_ENABLE)
 	//PSMݒ
 	//Enable power saving mode
-	//Requested_Periodic-TAU-ext 1hour x 6 = 6hour
-	//Requested_Active-Time 2sec x 0 = 0sec
+	//Requested_Periodic-TAU-ext CONFIG_UDP_PSM_TAU (l 1hour x 6 = 6hour)
+	//Requested_Active-Time CONFIG_UDP_PSM_ACTIVE_TIME (l 2sec x 0 = 0sec)
 	printk("\nPower saving mode setting\n");
-	printk("AT+CPSMS=1,\"\",\"\",\"00100110\",\"00000000\"\n");
-	err = nrf_modem_at_printf("AT+CPSMS=1,\"\",\"\",\"00100110\",\"00000000\"");
+	printk("AT+CPSMS=1,\"\",\"\",\"%s\",\"%s\"\n", CONFIG_UDP_PSM_TAU, CONFIG_UDP_PSM_ACTIVE_TIME);
+	err = nrf_modem_at_printf("AT+CPSMS=1,\"\",\"\",\"%s\",\"%s\"", CONFIG_UDP_PSM_TAU, CONFIG_UDP_PSM_ACTIVE_TIME);
 	if (err) {
 		printk(" *** AT+CPSMS failed\n");
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
 	}
+#endif
 
-	//PTWݒ
+#if defined(CONFIG_UDP_EDRX_ENABLE)
+	//PTWݒ CONFIG_UDP_EDRX_PTW
 	printk("\nPaging Time Window (PTW) setting\n");
-	printk("AT%%XPTW=4,\"1111\"\n");
-	err = nrf_modem_at_printf("AT%%XPTW=4,\"1111\"");
+	printk("AT%%XPTW=4,\"%s\"\n", CONFIG_UDP_EDRX_PTW);
+	err = nrf_modem_at_printf("AT%%XPTW=4,\"%s\"", CONFIG_UDP_EDRX_PTW);
 	if (err) {
 		printk(" *** AT%%XPTW failed\n");
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
 	}
 
-	//eDRXݒ
+	//eDRXݒ CONFIG_UDP_EDRX_VALUE
 	printk("\neDRX setting\n");
-	printk("AT+CEDRXS=2,4,\"1010\"\n");
-	err = nrf_modem_at_printf("AT+CEDRXS=2,4,\"1010\"");
+	printk("AT+CEDRXS=2,4,\"%s\"\n", CONFIG_UDP_EDRX_VALUE);
+	err = nrf_modem_at_printf("AT+CEDRXS=2,4,\"%s\"", CONFIG_UDP_EDRX_VALUE);
 	if (err) {
 		printk(" *** AT+CEDRXS failed\n");
 		printk("AT command error, type: %d\n\n", nrf_modem_at_err_type(err));
 	}
+#endif
 
 	err = lte_lc_connect_async(lte_handler);
 	printk("\nlte_lc_connect_async status %d\n",err);
@@ -962,24 +1343,35 @@ static int modem_connect(void)
 void main(void)
 {
 	int err;
-	int countSleepMin = 0;
 	int wdtSleepMin = 0;
+	uint32_t sleep_ms;
 
 	if (!device_is_ready(uart_dev)) {
 		printk("\n**** UART device not ready ****\n");
 	}
 
+	//Ӌ@\~Ap鏈̊ԂN
+	//R\[o͂UART̏ꍇ̓R\[o͒̂UARTN
+	power_init();
+	console_set_enable(true); //R\[o͗L
+
 	printk("\n\n------ LTE Water Level Gauge v1.1.0 ------\n");
 	printk(    "--- Development is SAKURA internet Inc.---\n");
 
 	wdt_init(); //WDT
+	profile_init(); //Ԍv
 
 	//EHb`hbO񐔂ŐڑsɃEFCg
 	printk("First boot %d\n", first_boot);
 	printk("WDT count %d\n", WDT_call_count);
 	if (first_boot != 0xAA) {
 		WDT_call_count = 0; //NZbg
+		server_slot_ms = SCHEDULE_NO_SLOT;
+		memset((void *)link_recovery_count, 0, sizeof(link_recovery_count));
 	}
+	uplink_queue_init(); //ZbgO̖Mf[^p
+	printk("Unsent payloads %d\n", uplink_queue_count());
+	defer_init(&defer_status, uplink_queue_count()); //Mf[^ƂƂɑMԂp
 	if (WDT_call_count >= 6) {
 		WDT_call_count = 0; //6ȏオZbgꂽ烊Zbg
 	}
@@ -991,22 +1383,35 @@ void main(void)
 		case 4: wdtSleepMin = 8; printk("sleep %dmin\n",wdtSleepMin); break; //8 (Đڑ4)
 		default:wdtSleepMin = 0; break; //PLMNύX (Đڑ5)
 	}
-	for (countSleepMin = wdtSleepMin; countSleepMin > 0; countSleepMin--) {
-		if (countSleepMin > 10) {
-			break; //10𒴂lZbgĂꍇ̓[v𔲂
-		}
+	//dȂǂňĂɋN[̐ڑdȂȂ悤҂Ԃ𕪎U
+	//WDTċN͐ݒl50%`150%AȊO0`CONFIG_UDP_SCHEDULE_BOOT_JITTER_SECONDS
+	if (wdtSleepMin > 0) {
+		sleep_ms = schedule_jitter_ms(wdtSleepMin * 60000, sys_rand32_get());
+	} else {
+		sleep_ms = sys_rand32_get() % (CONFIG_UDP_SCHEDULE_BOOT_JITTER_SECONDS * 1000 + 1);
+	}
+	while (sleep_ms > 0) {
 		wdt_feed(wdt_dev, wdt_main_channel);//WDTZbg
-		uart0_set_enable(true); //UARTL
-		printk("%d minute sleep remaining\n", countSleepMin);
-		uart0_set_enable(false); //UART~
-		k_sleep(K_SECONDS(60)); //1X[v
+		printk("%u second sleep remaining\n", (sleep_ms + 999) / 1000);
+		console_set_enable(false); //R\[o͒~
+		k_sleep(K_MSEC(MIN(sleep_ms, 60000))); //Œ1X[v
+		console_set_enable(true); //R\[o͗L
+		sleep_ms -= MIN(sleep_ms, 60000);
 	}
-	uart0_set_enable(true); //UARTL
 
 	gpio_init();     //GPIO
 	adc_init();      //ADC
 	i2c_init();      //I2C
 	work_init();     //UDPMXbh
+#if defined(CONFIG_UDP_FOTA_ENABLE)
+	fota_init();     //FOTA
+#endif
+	trace_init();    //g[X
+	seqno_init();    //N񐔁EV[PXԍ
+	trace_dump();    //ۑς݃g[XR\[ɏo
+#if defined(CONFIG_UDP_DTLS_ENABLE)
+	dtls_init();     //DTLSF؏񏑂 (LTEڑO)
+#endif
 	modem_init();    //LTEf
 	modem_connect(); //LTEڑpATR}hs
 
@@ -1035,4 +1440,8 @@ void main(void)
 
 	//UDPMXbhs
 	k_work_schedule(&server_transmission_work, K_NO_WAIT);
+#if defined(CONFIG_UDP_ALARM_ENABLE)
+	k_work_schedule(&alarm_sensing_work, K_SECONDS(CONFIG_UDP_ALARM_SENSING_SECONDS)); //xpȈՌvJn
+#endif
+	console_set_enable(false); //R\[o͒~
 }
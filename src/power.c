@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/pm/device_runtime.h>
+
+#include "power.h"
+
+static const struct device *const power_dev[POWER_DOMAIN_COUNT] = {
+	[POWER_UART] = DEVICE_DT_GET(DT_NODELABEL(uart0)),
+	[POWER_I2C]  = DEVICE_DT_GET(DT_NODELABEL(i2c2)),
+	[POWER_ADC]  = DEVICE_DT_GET(DT_NODELABEL(adc)),
+};
+
+//dǗ
+//PM_DEVICE_RUNTIME̗pǗLɂ (p0̂ߒ~ԂɂȂ)
+//dǗɑΉĂȂhCopower_get/power_putŉȂ
+int power_init(void)
+{
+	int err;
+	int a;
+
+	for (a = 0; a < POWER_DOMAIN_COUNT; a++) {
+		if (!device_is_ready(power_dev[a])) {
+			printk("Power domain %s not ready\n", power_dev[a]->name);
+			continue;
+		}
+		err = pm_device_runtime_enable(power_dev[a]);
+		if (err && err != -ENOTSUP) {
+			printk("Power domain %s runtime PM error: %d\n", power_dev[a]->name, err);
+		}
+	}
+
+	return 0;
+}
+
+//Ӌ@\̗pJn
+int power_get(enum power_domain domain)
+{
+	int err;
+
+	err = pm_device_runtime_get(power_dev[domain]);
+	if (err) {
+		printk("Power domain %s resume error: %d\n", power_dev[domain]->name, err);
+	}
+
+	return err;
+}
+
+//Ӌ@\̗pI
+int power_put(enum power_domain domain)
+{
+	int err;
+
+	err = pm_device_runtime_put(power_dev[domain]);
+	if (err) {
+		printk("Power domain %s suspend error: %d\n", power_dev[domain]->name, err);
+	}
+
+	return err;
+}
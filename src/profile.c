@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
+
+#include "profile.h"
+
+//ԂƂ̌v (TCN)
+struct profile_entry {
+	timing_t start;
+	uint32_t count;
+	uint32_t last;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+};
+
+static struct profile_entry profile_entries[PROFILE_STEP_COUNT];
+
+static const char *const profile_names[PROFILE_STEP_COUNT] = {
+	[PROFILE_CYCLE] = "cycle",
+	[PROFILE_RANGE] = "range",
+	[PROFILE_RANGE_PARSE] = "range_parse",
+	[PROFILE_RANGE_CHECK] = "range_check",
+	[PROFILE_AT_XMONITOR] = "at_xmonitor",
+	[PROFILE_PARSE_XMONITOR] = "parse_xmonitor",
+	[PROFILE_AT_CONEVAL] = "at_coneval",
+	[PROFILE_PARSE_CONEVAL] = "parse_coneval",
+	[PROFILE_AT_INFO] = "at_info",
+	[PROFILE_ADC] = "adc",
+	[PROFILE_TEMP] = "temp",
+	[PROFILE_FORMAT] = "format",
+	[PROFILE_SEND] = "send",
+};
+
+//TCNJE^(DWT)
+void profile_init(void)
+{
+	timing_init();
+	timing_start();
+}
+
+//ԊJn
+void profile_begin(enum profile_step step)
+{
+	profile_entries[step].start = timing_counter_get();
+}
+
+//ԏI (Ԃ𕡐ʂꍇ͍v)
+void profile_end(enum profile_step step)
+{
+	struct profile_entry *entry = &profile_entries[step];
+	timing_t end = timing_counter_get();
+	uint32_t cycles = (uint32_t)timing_cycles_get(&entry->start, &end);
+
+	if (entry->count == 0 || cycles < entry->min) {
+		entry->min = cycles;
+	}
+	if (cycles > entry->max) {
+		entry->max = cycles;
+	}
+	entry->last = cycles;
+	entry->total += cycles;
+	entry->count++;
+}
+
+//vʏo (PROFILE,Ԗ,,,ŏ,ő,[TCN],[ns])
+void profile_report(void)
+{
+	size_t unused = 0;
+	int step;
+
+	for (step = 0; step < PROFILE_STEP_COUNT; step++) {
+		struct profile_entry *entry = &profile_entries[step];
+		uint32_t avg;
+
+		if (entry->count == 0) {
+			continue;
+		}
+		avg = (uint32_t)(entry->total / entry->count);
+		printk("PROFILE,%s,%u,%u,%u,%u,%u,%u\n", profile_names[step], entry->count, entry->last, entry->min, entry->max, avg, (uint32_t)timing_cycles_to_ns(avg));
+	}
+
+	//[NL[X^bN̖gp
+	if (k_thread_stack_space_get(k_current_get(), &unused) == 0) {
+		printk("PROFILE,stack_unused,%u\n", (uint32_t)unused);
+	}
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ranging.h"
+
+#define SOUND_SPEED_0C_MM_S 331300 //0̉ (mm/s)
+#define SOUND_SPEED_PER_C_MM_S 606 //1̉̕ω (mm/s)
+
+//V[g^CvMB7389(5m) L͈301`4999mm (300mm͋߂Aos5000mm)
+const struct ranging_sensor ranging_mb7389 = {
+	.name = "MB7389",
+	.unit_mm = 1,
+	.range_code = 0,
+	.warmup_frames = 8,
+	.frame_period_ms = 150,
+	.min_mm = 300,
+	.max_mm = 4999,
+	.no_target = 5000,
+	.temp_compensated = true,
+};
+
+//V[g^CvMB7388(10m) L͈501`9998mm (500mm͋߂Aos9999mm)
+const struct ranging_sensor ranging_mb7388 = {
+	.name = "MB7388",
+	.unit_mm = 1,
+	.range_code = 1,
+	.warmup_frames = 8,
+	.frame_period_ms = 150,
+	.min_mm = 500,
+	.max_mm = 9998,
+	.no_target = 9999,
+	.temp_compensated = true,
+};
+
+//O^CvMB7051(10m) cmo L͈51`999cm (50cm͋߂A999cm𒴂l͌os)
+const struct ranging_sensor ranging_mb7051 = {
+	.name = "MB7051",
+	.unit_mm = 10,
+	.range_code = 1,
+	.warmup_frames = 8,
+	.frame_period_ms = 100,
+	.min_mm = 500,
+	.max_mm = 9998,
+	.no_target = 1000,
+	.temp_compensated = false,
+};
+
+//DIPXCb` 2 ON:MB7388(10m) OFF:MB7389(5m)
+//DIPXCb` 3 ON:MB7051(10m) OFF:MB7389(5m) (2ԂD)
+const struct ranging_sensor *ranging_select(int sw2, int sw3)
+{
+	if (sw3 == 1) {
+		return &ranging_mb7051;
+	}
+	if (sw2 == 1) {
+		return &ranging_mb7388;
+	}
+	return &ranging_mb7389;
+}
+
+//vlG[̌
+int ranging_error_count(const int16_t *range_mm, int count)
+{
+	int err = 0;
+	int a;
+
+	for (a = 0; a < count; a++) {
+		if (range_mm[a] < 0) {
+			err++;
+		}
+	}
+
+	return err;
+}
+
+//LȌvlɕׂ (߂l͌)
+static int ranging_sort_valid(const int16_t *range_mm, int count, int16_t *valid)
+{
+	int16_t tmp;
+	int n = 0;
+	int a, i;
+
+	for (a = 0; a < count && n < RANGING_FRAME_COUNT; a++) {
+		if (range_mm[a] >= 0) {
+			valid[n++] = range_mm[a];
+		}
+	}
+
+	//}\[g (őRANGING_FRAME_COUNT)
+	for (a = 1; a < n; a++) {
+		tmp = valid[a];
+		for (i = a; i > 0 && valid[i - 1] > tmp; i--) {
+			valid[i] = valid[i - 1];
+		}
+		valid[i] = tmp;
+	}
+
+	return n;
+}
+
+//LȌvl̒l
+int16_t ranging_median(const int16_t *range_mm, int count)
+{
+	int16_t valid[RANGING_FRAME_COUNT];
+	int n;
+
+	n = ranging_sort_valid(range_mm, count, valid);
+	if (n == 0) {
+		return RANGING_ERROR;
+	}
+
+	return valid[n / 2];
+}
+
+//l苗ȓ̌vl̕ (tools/ingest.py reliable_distance Ɠ)
+//̒l͒2̕ς̂߁Ar2{̒lōs
+int16_t ranging_reliable(const int16_t *range_mm, int count)
+{
+	int16_t valid[RANGING_FRAME_COUNT];
+	int32_t median2, diff2, sum = 0;
+	int n, kept = 0;
+	int a;
+
+	n = ranging_sort_valid(range_mm, count, valid);
+	if (n == 0) {
+		return RANGING_ERROR;
+	}
+
+	median2 = (n % 2) ? 2 * valid[n / 2] : valid[n / 2 - 1] + valid[n / 2];
+	for (a = 0; a < n; a++) {
+		diff2 = 2 * valid[a] - median2;
+		if (diff2 > -2 * RANGING_MEDIAN_WINDOW_MM && diff2 < 2 * RANGING_MEDIAN_WINDOW_MM) {
+			sum += valid[a];
+			kept++;
+		}
+	}
+	if (kept == 0) {
+		return RANGING_ERROR;
+	}
+
+	return (int16_t)((sum + kept / 2) / kept);
+}
+
+//̉x␳W c(T) / c(x) (Q16)
+//c(T) = 331.3 + 0.606T [m/s] 1/16Pʂ̐ŌvZ (_͎gȂ)
+uint32_t ranging_temp_factor_q16(int16_t temp_c16)
+{
+	uint32_t speed = SOUND_SPEED_0C_MM_S * 16 + SOUND_SPEED_PER_C_MM_S * temp_c16;
+	uint32_t ref = SOUND_SPEED_0C_MM_S * 16 + SOUND_SPEED_PER_C_MM_S * RANGING_TEMP_REF_C16;
+
+	return (uint32_t)((((uint64_t)speed << 16) + ref / 2) / ref);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "schedule.h"
+
+//ICCID狁߂鑗Mʒu (FNV-1a 32bit)
+uint32_t schedule_phase_ms(const char *iccid, uint32_t period_ms)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*iccid != '\0') {
+		hash ^= (uint8_t)*iccid++;
+		hash *= 16777619u;
+	}
+
+	return period_ms ? hash % period_ms : 0;
+}
+
+//2000N11̕bɕϊ (^C][͑S[ŋʂ̂ߖ)
+int64_t schedule_cclk_to_s(const char *cclk)
+{
+	static const uint16_t days_before_month[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+	int year, month, day, hour, min, sec;
+	int64_t days;
+
+	if (sscanf(cclk, "%2d/%2d/%2d,%2d:%2d:%2d", &year, &month, &day, &hour, &min, &sec) != 6 ||
+	    month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || min > 59 || sec > 60) {
+		return -1;
+	}
+
+	days = year * 365 + (year + 3) / 4 + days_before_month[month - 1] + day - 1;
+	if (month > 2 && year % 4 == 0) {
+		days++; //邤N (2000`2099N)
+	}
+
+	return ((days * 24 + hour) * 60 + min) * 60 + sec;
+}
+
+//̑Mʒu܂ł̑҂ms
+uint32_t schedule_next_ms(int64_t now_ms, uint32_t phase_ms, uint32_t period_ms, uint32_t min_ms)
+{
+	uint32_t pos, delay;
+
+	if (period_ms == 0) {
+		return min_ms;
+	}
+
+	pos = (uint32_t)(now_ms % period_ms);
+	delay = (phase_ms % period_ms + period_ms - pos) % period_ms;
+	while (delay < min_ms) {
+		delay += period_ms;
+	}
+
+	return delay;
+}
+
+//҂ԂɃWb^
+uint32_t schedule_jitter_ms(uint32_t base_ms, uint32_t random)
+{
+	if (base_ms == 0) {
+		return 0;
+	}
+
+	return base_ms / 2 + random % base_ms;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+
+#include "seqno.h"
+
+#define SEQNO_MAGIC 0x53510001
+
+//V[PXԍ (ΏۊOϐ̒` WDTEVXeZbĝ܂ܑ)
+//tbVɂ SEQNO_RESERVE ܂ł̗\lۑAdf͗\lĊJ
+struct seqno_state {
+	uint32_t magic;
+	uint32_t seq;      //̃V[PXԍ
+	uint32_t reserved; //tbVɕۑ\l (seqɒBXV)
+};
+
+static struct seqno_state state __attribute__((section(".noinit.seqno")));
+static uint32_t boot_count;     //N (ݒ̈ seq/boot)
+static uint32_t saved_reserved; //ݒ̗̈\l (seq/reserved)
+
+//ݒ̈̓ǂݏo (seq/boot, seq/reserved)
+static int seqno_load_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	uint32_t *value = NULL;
+
+	if (strcmp(key, "boot") == 0) {
+		value = &boot_count;
+	} else if (strcmp(key, "reserved") == 0) {
+		value = &saved_reserved;
+	}
+	if (value != NULL && read_cb(cb_arg, value, sizeof(*value)) != sizeof(*value)) {
+		*value = 0;
+	}
+	return 0;
+}
+
+//V[PXԍ
+int seqno_init(void)
+{
+	int err;
+
+	err = settings_subsys_init();
+	if (err) {
+		printk("settings_subsys_init failed: %d\n", err);
+		return err;
+	}
+	settings_load_subtree_direct("seq", seqno_load_cb, NULL);
+
+	boot_count++;
+	settings_save_one("seq/boot", &boot_count, sizeof(boot_count));
+
+	//dfȂǂŏΏۊOϐȏꍇ͗\lĊJ
+	if (state.magic != SEQNO_MAGIC || state.reserved != saved_reserved || state.seq > state.reserved) {
+		state.magic = SEQNO_MAGIC;
+		state.seq = saved_reserved;
+		state.reserved = saved_reserved;
+	}
+	printk("Boot %u sequence %u\n", boot_count, state.seq);
+
+	return 0;
+}
+
+//N
+uint32_t seqno_boot_count(void)
+{
+	return boot_count;
+}
+
+//̃V[PXԍ
+uint32_t seqno_next(void)
+{
+	if (state.seq >= state.reserved) {
+		state.reserved = state.seq + SEQNO_RESERVE;
+		saved_reserved = state.reserved;
+		settings_save_one("seq/reserved", &saved_reserved, sizeof(saved_reserved));
+	}
+
+	return state.seq++;
+}
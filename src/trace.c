@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "trace.h"
+
+#define TRACE_UART_GAP_MS 5     //MԊuȏ̏ꍇ͎UARTR[hɕ
+#define TRACE_DUMP_BYTES 64     //R\[o1s̃oCg
+#define TRACE_DOWNLINK_CHUNK 512 //_EN1f[^ÕoCg
+
+//_EN [}WbN 'T','R'][Xbg][ԍ][][f[^]
+#define TRACE_DOWNLINK_HDR_SIZE 5
+
+static uint8_t trace_buf[CONFIG_UDP_TRACE_BUFFER_SIZE]; //1̃g[X (ۑς݃g[X̓ǂݏoɂg)
+static size_t trace_len;         //g[X
+static int trace_uart_rec = -1;  //ǋLUARTR[hʒu (-1:Ȃ)
+static int64_t trace_last_ms;    //ŐL^
+static bool trace_anomaly;       //ُ̂
+static bool trace_truncated;     //obt@sŋL^łȂR[h
+static uint8_t trace_next_slot;  //ɕۑXbg (ݒ̈ɕۑ)
+static size_t trace_load_len;    //ǂݏog[X
+
+//ŐL^̌oms
+static uint16_t trace_delta(void)
+{
+	int64_t now = k_uptime_get();
+	int64_t delta = now - trace_last_ms;
+
+	trace_last_ms = now;
+	return delta > UINT16_MAX ? UINT16_MAX : (uint16_t)delta;
+}
+
+//R[hǉ (f[^̈ԂBobt@s̏ꍇNULL)
+static uint8_t *trace_record(enum trace_type type, size_t len)
+{
+	uint8_t *rec;
+
+	trace_uart_rec = -1;
+	if (len > UINT8_MAX) {
+		len = UINT8_MAX;
+	}
+	if (trace_len + TRACE_RECORD_HDR_SIZE + len > sizeof(trace_buf)) {
+		trace_truncated = true;
+		return NULL;
+	}
+
+	rec = &trace_buf[trace_len];
+	rec[0] = type;
+	sys_put_le16(trace_delta(), &rec[1]);
+	rec[3] = len;
+	trace_len += TRACE_RECORD_HDR_SIZE + len;
+
+	return &rec[TRACE_RECORD_HDR_SIZE];
+}
+
+//ݒ̈̓ǂݏo (trace/next, trace/<Xbg>)
+static int trace_load_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	const char *name = param;
+	ssize_t n;
+
+	if (strcmp(key, name) != 0) {
+		return 0;
+	}
+
+	if (strcmp(name, "next") == 0) {
+		if (read_cb(cb_arg, &trace_next_slot, sizeof(trace_next_slot)) != sizeof(trace_next_slot) ||
+		    trace_next_slot >= CONFIG_UDP_TRACE_SLOTS) {
+			trace_next_slot = 0;
+		}
+		return 0;
+	}
+
+	n = read_cb(cb_arg, trace_buf, MIN(len, sizeof(trace_buf)));
+	trace_load_len = n > 0 ? n : 0;
+	return 0;
+}
+
+//ۑς݃g[X̓ǂݏo (trace_bufɓǂݍ)
+static size_t trace_load(int slot)
+{
+	char name[4];
+
+	snprintf(name, sizeof(name), "%d", slot);
+	trace_len = 0;
+	trace_uart_rec = -1;
+	trace_load_len = 0;
+	settings_load_subtree_direct("trace", trace_load_cb, name);
+
+	return trace_load_len;
+}
+
+//g[X
+int trace_init(void)
+{
+	int err;
+
+	err = settings_subsys_init();
+	if (err) {
+		printk("settings_subsys_init failed: %d\n", err);
+		return err;
+	}
+
+	return settings_load_subtree_direct("trace", trace_load_cb, "next");
+}
+
+//̊Jn
+void trace_begin(const char *sensor_name)
+{
+	uint8_t *data;
+	size_t len = strlen(sensor_name);
+
+	trace_len = 0;
+	trace_anomaly = false;
+	trace_truncated = false;
+	trace_last_ms = k_uptime_get();
+
+	data = trace_record(TRACE_CYCLE, 4 + len);
+	if (data != NULL) {
+		sys_put_le32((uint32_t)trace_last_ms, data);
+		memcpy(&data[4], sensor_name, data[-1] - 4);
+	}
+}
+
+//gZT[M1oCg
+void trace_uart(char c)
+{
+	uint8_t *data;
+
+	//OUARTR[hɑĎMꍇ͒ǋL
+	if (trace_uart_rec >= 0 && k_uptime_get() - trace_last_ms < TRACE_UART_GAP_MS &&
+	    trace_buf[trace_uart_rec + 3] < UINT8_MAX && trace_len < sizeof(trace_buf)) {
+		trace_buf[trace_uart_rec + 3]++;
+		trace_buf[trace_len++] = c;
+		trace_last_ms = k_uptime_get();
+		return;
+	}
+
+	data = trace_record(TRACE_UART, 1);
+	if (data != NULL) {
+		data[0] = c;
+		trace_uart_rec = trace_len - TRACE_RECORD_HDR_SIZE - 1;
+	}
+}
+
+//ATR}hƉ
+void trace_at(const char *cmd, const char *response)
+{
+	uint8_t *data;
+
+	data = trace_record(TRACE_AT_CMD, strlen(cmd));
+	if (data != NULL) {
+		memcpy(data, cmd, data[-1]);
+	}
+	data = trace_record(TRACE_AT_RESP, strlen(response));
+	if (data != NULL) {
+		memcpy(data, response, data[-1]);
+	}
+}
+
+//茋
+void trace_event(enum trace_event event, int16_t value)
+{
+	uint8_t *data;
+
+	data = trace_record(TRACE_EVENT, 3);
+	if (data != NULL) {
+		data[0] = event;
+		sys_put_le16((uint16_t)value, &data[1]);
+	}
+
+	switch (event) {
+	case TRACE_EV_SENSING:
+		trace_anomaly |= (value >= 3); //gCΏ
+		break;
+	case TRACE_EV_RETRY:
+	case TRACE_EV_ALARM:
+		trace_anomaly |= (value != 0);
+		break;
+	case TRACE_EV_DEFER:
+		break; //dg󋵂ɂ鉄͒ʏ퓮
+	default:
+		trace_anomaly = true;
+		break;
+	}
+}
+
+//̏I
+void trace_end(void)
+{
+	char name[12];
+	int err;
+
+	if (!trace_anomaly && !IS_ENABLED(CONFIG_UDP_TRACE_ALL)) {
+		return;
+	}
+
+	snprintf(name, sizeof(name), "trace/%d", trace_next_slot);
+	err = settings_save_one(name, trace_buf, trace_len);
+	if (err) {
+		printk("Trace save failed: %d\n", err);
+		return;
+	}
+	printk("Trace saved slot %d, %zu bytes%s\n", trace_next_slot, trace_len, trace_truncated ? " (truncated)" : "");
+
+	trace_next_slot = (trace_next_slot + 1) % CONFIG_UDP_TRACE_SLOTS;
+	settings_save_one("trace/next", &trace_next_slot, sizeof(trace_next_slot));
+}
+
+//ۑς݃g[XR\[ɏo (Â)
+void trace_dump(void)
+{
+	size_t len, offset, i;
+	char hex[TRACE_DUMP_BYTES * 2 + 1];
+	int a, slot;
+
+	for (a = 0; a < CONFIG_UDP_TRACE_SLOTS; a++) {
+		slot = (trace_next_slot + a) % CONFIG_UDP_TRACE_SLOTS;
+		len = trace_load(slot);
+		for (offset = 0; offset < len; offset += TRACE_DUMP_BYTES) {
+			for (i = 0; i < TRACE_DUMP_BYTES && offset + i < len; i++) {
+				snprintf(&hex[i * 2], 3, "%02x", trace_buf[offset + i]);
+			}
+			printk("TRACE,%d,%zu,%s\n", slot, offset, hex);
+		}
+	}
+	trace_len = 0;
+}
+
+//ۑς݃g[X𑗐M (Â)
+void trace_send(int fd)
+{
+	uint8_t pkt[TRACE_DOWNLINK_HDR_SIZE + TRACE_DOWNLINK_CHUNK];
+	size_t len, offset;
+	int a, slot, part, parts;
+
+	printk("Trace requested\n");
+
+	for (a = 0; a < CONFIG_UDP_TRACE_SLOTS; a++) {
+		slot = (trace_next_slot + a) % CONFIG_UDP_TRACE_SLOTS;
+		len = trace_load(slot);
+		parts = (len + TRACE_DOWNLINK_CHUNK - 1) / TRACE_DOWNLINK_CHUNK;
+		for (part = 0; part < parts; part++) {
+			offset = part * TRACE_DOWNLINK_CHUNK;
+			pkt[0] = 'T';
+			pkt[1] = 'R';
+			pkt[2] = slot;
+			pkt[3] = part;
+			pkt[4] = parts;
+			memcpy(&pkt[TRACE_DOWNLINK_HDR_SIZE], &trace_buf[offset], MIN(len - offset, TRACE_DOWNLINK_CHUNK));
+			if (send(fd, pkt, TRACE_DOWNLINK_HDR_SIZE + MIN(len - offset, TRACE_DOWNLINK_CHUNK), 0) < 0) {
+				printk("Trace send failed: %d\n", errno);
+				return;
+			}
+		}
+	}
+	trace_len = 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "uplink_queue.h"
+
+#define UPLINK_QUEUE_MAGIC 0x55510001
+
+//Mf[^(ΏۊOϐ̒` Zbg̑Mōđ)
+struct uplink_queue {
+	uint32_t magic;
+	uint8_t head;  //łÂf[^̈ʒu
+	uint8_t count; //f[^
+	char payload[UPLINK_QUEUE_LEN][UPLINK_PAYLOAD_SIZE];
+};
+
+static struct uplink_queue queue __attribute__((section(".noinit.uplink")));
+
+//Mf[^L[
+void uplink_queue_init(void)
+{
+	int a;
+
+	if (queue.magic == UPLINK_QUEUE_MAGIC && queue.head < UPLINK_QUEUE_LEN && queue.count <= UPLINK_QUEUE_LEN) {
+		for (a = 0; a < UPLINK_QUEUE_LEN; a++) {
+			if (memchr(queue.payload[a], '\0', UPLINK_PAYLOAD_SIZE) == NULL) {
+				break;
+			}
+		}
+		if (a == UPLINK_QUEUE_LEN) {
+			return;
+		}
+	}
+
+	memset(&queue, 0, sizeof(queue));
+	queue.magic = UPLINK_QUEUE_MAGIC;
+}
+
+//Mf[^ǉ
+void uplink_queue_push(const char *payload)
+{
+	char *slot;
+
+	if (queue.count == UPLINK_QUEUE_LEN) {
+		uplink_queue_pop();
+	}
+	slot = queue.payload[(queue.head + queue.count) % UPLINK_QUEUE_LEN];
+	strncpy(slot, payload, UPLINK_PAYLOAD_SIZE - 1);
+	slot[UPLINK_PAYLOAD_SIZE - 1] = '\0';
+	queue.count++;
+}
+
+//łÂMf[^
+const char *uplink_queue_peek(void)
+{
+	if (queue.count == 0) {
+		return NULL;
+	}
+	return queue.payload[queue.head];
+}
+
+//łÂMf[^폜
+void uplink_queue_pop(void)
+{
+	if (queue.count == 0) {
+		return;
+	}
+	queue.payload[queue.head][0] = '\0';
+	queue.head = (queue.head + 1) % UPLINK_QUEUE_LEN;
+	queue.count--;
+}
+
+//Mf[^
+int uplink_queue_count(void)
+{
+	return queue.count;
+}
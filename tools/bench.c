@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//Xebṽx`}[N (zXgp)
+//v̊eŒ͂ŌJԂsA1񂠂̎ԂƃX^bNgpʂ CSV ŏo͂B
+//o͂ tools/profile_diff.py ŔrłB
+//
+//  ./tools/bench.sh > base.csv              (r̃R~bgŎs)
+//  ./tools/bench.sh > new.csv
+//  ./tools/profile_diff.py base.csv new.csv
+//  ./tools/bench.sh -n 100000               (JԂ񐔂w)
+//
+//o step,ns_per_op,stack_bytes
+//stack_bytes ͊eXebv1񕪂̃X^bNgp (̃XebvƂ̍ WX^ōςޏ0)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ranging.h"
+#include "at_parse.h"
+#include "batt.h"
+#include "payload.h"
+
+#define BENCH_ITERATIONS 1000000 //̌JԂ
+#define BENCH_STACK_SIZE (64 * 1024)
+#define BENCH_STACK_PAINT 0xa5
+
+//Œ (src/main.c ̃Rg̉)
+static const char frames[] = "R0120\rR0118\rR0121\rR9999\rR0119\r";
+static const char xmonitor_response[] =
+	"5,\"KDDI\",\"KDDI\",\"44051\",\"185C\",7,18,\"008AAA5C\",316,5900,44,22,\"1010\",\"00000000\",\"00100111\",\"01011111\"";
+static const char coneval_response[] = "0,0,6,42,3,17,\"008AAA5C\",\"44051\",331,5900,18,0,0,4,2,8,117";
+static const int16_t adc_samples[BATT_SAMPLES] = {
+	1780, 1782, 1779, 1781, 1783, 1780, 1778, 1781, 1782, 1780,
+};
+
+//œKŏȂ悤ʂo
+static volatile int32_t sink;
+
+static void step_none(void)
+{
+}
+
+//ZT[o 5t[̎M
+static void step_frame_push(void)
+{
+	struct ranging_frame frame;
+	const char *p;
+
+	ranging_frame_reset(&frame);
+	for (p = frames; *p != '\0'; p++) {
+		if (ranging_frame_push(&frame, *p)) {
+			sink = frame.value;
+			ranging_frame_reset(&frame);
+		}
+	}
+}
+
+//5t[mmϊ
+static void step_convert(void)
+{
+	static const struct ranging_frame input[RANGING_FRAME_COUNT] = {
+		{ .value = 1200, .digits = 4, .done = true },
+		{ .value = 1180, .digits = 4, .done = true },
+		{ .value = 1210, .digits = 4, .done = true },
+		{ .value = 9999, .digits = 4, .done = true },
+		{ .value = 1190, .digits = 4, .done = true },
+	};
+	int a;
+
+	for (a = 0; a < RANGING_FRAME_COUNT; a++) {
+		sink = ranging_convert(&ranging_mb7389, &input[a]);
+	}
+}
+
+static void step_error_count(void)
+{
+	static const int16_t range_mm[RANGING_FRAME_COUNT] = { 1200, 1180, RANGING_ERROR, 1210, 1190 };
+
+	sink = ranging_error_count(range_mm, RANGING_FRAME_COUNT);
+}
+
+//͉͂ŏ邽ߖRs[ ([łAT̎MƂɃobt@)
+static void step_parse_xmonitor(void)
+{
+	char buffer[128];
+	struct xmonitor_info info;
+
+	memcpy(buffer, xmonitor_response, sizeof(xmonitor_response));
+	sink = at_parse_xmonitor(buffer, &info);
+}
+
+static void step_parse_coneval(void)
+{
+	char buffer[128];
+	struct coneval_info info;
+
+	memcpy(buffer, coneval_response, sizeof(coneval_response));
+	sink = at_parse_coneval(buffer, &info);
+}
+
+//M񐶐 (CONFIG_UDP_PAYLOAD_EXTENDED=y )
+static void step_format(void)
+{
+	char buffer[256];
+	int len;
+
+	len = sprintf(buffer, PAYLOAD_FORMAT, "23/05/01,12:34:56+36", "8981040000000000000", 2732, '+', 21, 50,
+	              1200, 1180, 1210, -1, 1190, 123, "18", "\"44051\"", "\"185C\"", "\"008AAA5C\"",
+	              "6", "42", "3", "17", 0, 0, 0, 0U, 0U, 0U, 0U, 12U, 3456U);
+	len += sprintf(buffer + len, PAYLOAD_FORMAT_EXTENDED, 0U, 0U, 0, 1196);
+	sink = len;
+}
+
+static void step_batt(void)
+{
+	sink = batt_mv(adc_samples, BATT_SAMPLES);
+}
+
+struct step {
+	const char *name;
+	void (*fn)(void);
+	double ns;
+	size_t stack;
+};
+
+static struct step steps[] = {
+	{ .name = "none", .fn = step_none },
+	{ .name = "range_frame_push", .fn = step_frame_push },
+	{ .name = "range_convert", .fn = step_convert },
+	{ .name = "range_error_count", .fn = step_error_count },
+	{ .name = "parse_xmonitor", .fn = step_parse_xmonitor },
+	{ .name = "parse_coneval", .fn = step_parse_coneval },
+	{ .name = "format", .fn = step_format },
+	{ .name = "batt", .fn = step_batt },
+};
+
+static long iterations = BENCH_ITERATIONS;
+
+//X^bNgpʂ𑪂邽߁AeXebv͓hԂX^bNXbh1񂾂s
+static void *stack_thread(void *arg)
+{
+	((struct step *)arg)->fn();
+	return NULL;
+}
+
+static size_t measure_stack(struct step *step)
+{
+	static uint8_t stack[BENCH_STACK_SIZE] __attribute__((aligned(4096)));
+	pthread_attr_t attr;
+	pthread_t thread;
+	size_t a;
+
+	memset(stack, BENCH_STACK_PAINT, sizeof(stack));
+	pthread_attr_init(&attr);
+	pthread_attr_setstack(&attr, stack, sizeof(stack));
+	if (pthread_create(&thread, &attr, stack_thread, step) != 0) {
+		fprintf(stderr, "pthread_create failed\n");
+		exit(2);
+	}
+	pthread_join(thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	//X^bN͉ʃAhXɌĐLт
+	for (a = 0; a < sizeof(stack) && stack[a] == BENCH_STACK_PAINT; a++) {
+	}
+	return sizeof(stack) - a;
+}
+
+static double measure_time(const struct step *step)
+{
+	struct timespec start, end;
+	long n;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (n = 0; n < iterations; n++) {
+		step->fn();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	int count = sizeof(steps) / sizeof(steps[0]);
+	int a;
+
+	if (argc == 3 && strcmp(argv[1], "-n") == 0 && atol(argv[2]) > 0) {
+		iterations = atol(argv[2]);
+	} else if (argc != 1) {
+		fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+		return 2;
+	}
+
+	for (a = 0; a < count; a++) {
+		steps[a].stack = measure_stack(&steps[a]);
+		steps[a].ns = measure_time(&steps[a]);
+	}
+
+	//̃Xebv (ĂяoƃXbhN̕) 
+	printf("step,ns_per_op,stack_bytes\n");
+	for (a = 1; a < count; a++) {
+		printf("%s,%.1f,%zu\n", steps[a].name, steps[a].ns - steps[0].ns,
+		       steps[a].stack > steps[0].stack ? steps[a].stack - steps[0].stack : 0);
+	}
+
+	return 0;
+}
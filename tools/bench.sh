@@ -0,0 +1,12 @@
+#!/bin/bash -xe
+
+# Benchmark the processing steps of src/ranging.c, src/at_parse.c, src/batt.c and the payload format on the host
+# usage: ./tools/bench.sh [-n iterations] > result.csv
+# Compare two results with ./tools/profile_diff.py base.csv new.csv
+
+BUILD_DIR=build/host
+
+mkdir -p $BUILD_DIR
+cc -O2 -Wall -Iinclude -o $BUILD_DIR/bench tools/bench.c src/ranging.c src/at_parse.c src/batt.c -lpthread
+
+$BUILD_DIR/bench "$@"
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//M̊mF (zXgp)
+//src/defer.c ɃGlM[l̗ʂAEExEߖd͗ʂ̌vZzǂ肩mFB
+//ݒl͊l (M116bAES 7ERSRP -125dBmŉA600b) ŌŒB
+//
+//  ./tools/defer_check.sh
+//
+//IR[h 0:v 1:sv
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "defer.h"
+
+#define PERIOD_MS (CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS * 1000LL)
+#define RSRP_GOOD -100 //ȂMd (dBm)
+
+static int failures;
+
+static void check(const char *name, long long actual, long long expected)
+{
+	printf("%-32s %6lld %6lld %s\n", name, actual, expected, actual == expected ? "ok" : "NG");
+	if (actual != expected) {
+		failures++;
+	}
+}
+
+int main(void)
+{
+	struct defer_state state;
+	int64_t now = 0;
+	int a;
+
+	memset(&state, 0xA5, sizeof(state)); //d̏ΏۊOϐ
+	defer_init(&state, 0);
+	check("init magic", state.magic == DEFER_MAGIC, 1);
+	check("init deferred", state.deferred, 0);
+
+	//dg󋵗ǍDEAT%CONEVAL擾s͉Ȃ
+	check("es 8", defer_evaluate(&state, 8, RSRP_GOOD, false, false, now), DEFER_SEND);
+	check("es unknown", defer_evaluate(&state, 0, RSRP_GOOD, false, false, now), DEFER_SEND);
+	defer_sent(&state, 8);
+	check("saved without deferral", state.saved, 0);
+
+	//ES 6 (40)  RSRPsES 8 (14) AES 9 (10) őM
+	check("es 6", defer_evaluate(&state, 6, RSRP_GOOD, false, false, now), DEFER_HOLD);
+	now += PERIOD_MS;
+	check("es 8 rsrp -130", defer_evaluate(&state, 8, -130, false, false, now), DEFER_HOLD);
+	check("pending", state.pending, 2);
+	check("pending cost", state.pending_cost, 40 + 14);
+	now += PERIOD_MS;
+	check("es 9", defer_evaluate(&state, 9, RSRP_GOOD, false, false, now), DEFER_SEND);
+	defer_sent(&state, 9);
+	check("saved", state.saved, 40 + 14 - 2 * 10);
+	check("pending after send", state.pending, 0);
+
+	//x͉Ȃ
+	check("alarm es 5", defer_evaluate(&state, 5, RSRP_GOOD, true, false, now), DEFER_SEND_URGENT);
+	check("forced", state.forced, 1);
+	defer_sent(&state, 5);
+
+	//: łÂf[^̎600b𒴂鎞_őM (116b5񉄊A6ڂɑM)
+	for (a = 0; a < 5; a++) {
+		check("deadline hold", defer_evaluate(&state, 5, RSRP_GOOD, false, false, now), DEFER_HOLD);
+		now += PERIOD_MS;
+	}
+	check("deadline send", defer_evaluate(&state, 5, RSRP_GOOD, false, false, now), DEFER_SEND_DEADLINE);
+	check("forced", state.forced, 2);
+	defer_sent(&state, 5);
+	check("saved after deadline", state.saved, 34); //ƓES 5őMߐߖȂ
+
+	//Mf[^t
+	check("queue full", defer_evaluate(&state, 6, RSRP_GOOD, false, true, now), DEFER_SEND_DEADLINE);
+	check("deferred", state.deferred, 2 + 5);
+
+	//Zbg͏WvlpÃf[^͋N_琔
+	check("hold before reset", defer_evaluate(&state, 6, RSRP_GOOD, false, false, now), DEFER_HOLD);
+	defer_init(&state, 1);
+	check("reset deferred", state.deferred, 8);
+	check("reset pending", state.pending, 1);
+	check("reset oldest", state.oldest_ms, 0);
+	defer_init(&state, 0); //Mf[^Ăꍇ
+	check("reset pending lost", state.pending, 0);
+	check("reset pending cost lost", state.pending_cost, 0);
+
+	printf("%s\n", failures == 0 ? "OK" : "NG");
+	return failures == 0 ? 0 : 1;
+}
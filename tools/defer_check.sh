@@ -0,0 +1,13 @@
+#!/bin/bash -xe
+
+# Check the deferral, deadline and energy saving arithmetic of src/defer.c on the host
+# usage: ./tools/defer_check.sh
+
+BUILD_DIR=build/host
+
+mkdir -p $BUILD_DIR
+cc -O2 -Wall -Iinclude -DCONFIG_UDP_DEFER_ENABLE=1 -DCONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS=116 \
+    -DCONFIG_UDP_DEFER_MIN_ES=7 -DCONFIG_UDP_DEFER_MIN_RSRP_DBM=-125 -DCONFIG_UDP_DEFER_DEADLINE_SECONDS=600 \
+    -o $BUILD_DIR/defer_check tools/defer_check.c src/defer.c
+
+$BUILD_DIR/defer_check "$@"
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 SAKURA internet Inc.
+#
+# SPDX-License-Identifier: MIT
+#
+# Bytes on air per uplink, plaintext UDP compared with DTLS 1.2.
+#
+#   ./tools/dtls_overhead.py                         (model, typical payload)
+#   ./tools/dtls_overhead.py --uplinks 744           (one handshake per 744 uplinks, a day at 116s)
+#   ./tools/dtls_overhead.py --pcap dtls.pcap        (measured, capture of tools/dtls_server.sh)
+#
+# The model counts IPv4 + UDP + DTLS record headers for TLS_PSK_WITH_AES_128_CCM_8,
+# with and without a Connection ID, and spreads one full PSK handshake over --uplinks
+# application records. The handshake size is an estimate; use --pcap for the real figure.
+
+import argparse
+import struct
+import sys
+
+IP_UDP = 28            # IPv4 20 + UDP 8
+RECORD_HEADER = 13     # type, version, epoch, sequence number, length
+CCM8 = 8 + 8           # explicit nonce + 8 byte tag
+CID_INNER_TYPE = 1     # tls12_cid records carry the real content type in the plaintext
+HANDSHAKE_EST = 650    # full PSK handshake with cookie exchange, both directions
+
+# Typical uplink of src/main.c
+PAYLOAD = ('23/10/18,12:00:00+36,8981040000001220198,3600,+21.50,2540,2541,2539,2540,2542,0000000001,'
+           '18,"44020","185C","008AAA5C",6,042,020,030,0,00,0,0,0,0,0')
+
+CONTENT = {20: "change_cipher_spec", 21: "alert", 22: "handshake", 23: "application_data", 25: "tls12_cid"}
+
+
+def model(payload_len, uplinks, cid_len):
+    plain = IP_UDP + payload_len
+    dtls = IP_UDP + RECORD_HEADER + CCM8 + payload_len
+    dtls_cid = dtls + cid_len + CID_INNER_TYPE
+    print("payload %d bytes, handshake estimate %d bytes per %d uplinks" % (payload_len, HANDSHAKE_EST, uplinks))
+    print("mode,bytes_per_uplink,with_handshake,overhead_percent")
+    for name, size in (("udp", plain), ("dtls", dtls), ("dtls_cid%d" % cid_len, dtls_cid)):
+        total = size + (HANDSHAKE_EST / uplinks if name != "udp" else 0)
+        print("%s,%d,%.1f,%.1f" % (name, size, total, (total - plain) * 100 / plain))
+
+
+def pcap_datagrams(path, port):
+    """UDP datagrams to or from `port` in a pcap file (Ethernet, raw IP or Linux cooked)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    magic = struct.unpack("<I", data[:4])[0]
+    endian = "<" if magic in (0xa1b2c3d4, 0xa1b23c4d) else ">"
+    linktype = struct.unpack(endian + "I", data[20:24])[0]
+    offset = {1: 14, 101: 0, 113: 16, 276: 20}.get(linktype)
+    if offset is None:
+        sys.exit("unsupported link type %d" % linktype)
+    pos = 24
+    while pos + 16 <= len(data):
+        caplen = struct.unpack(endian + "I", data[pos + 8:pos + 12])[0]
+        frame = data[pos + 16:pos + 16 + caplen]
+        pos += 16 + caplen
+        ip = frame[offset:]
+        if len(ip) < 28 or ip[0] >> 4 != 4 or ip[9] != 17:
+            continue
+        ihl = (ip[0] & 0x0f) * 4
+        sport, dport = struct.unpack(">HH", ip[ihl:ihl + 4])
+        if port in (sport, dport):
+            yield dport == port, struct.unpack(">H", ip[2:4])[0], ip[ihl + 8:]
+
+
+def measure(path, port):
+    records = {}
+    uplinks = 0
+    for to_server, ip_len, udp in pcap_datagrams(path, port):
+        kind = CONTENT.get(udp[0], "other") if udp else "other"
+        key = (kind, "up" if to_server else "down")
+        count, total = records.get(key, (0, 0))
+        records[key] = (count + 1, total + ip_len)
+        if to_server and kind in ("application_data", "tls12_cid"):
+            uplinks += 1
+    print("record,direction,datagrams,bytes_on_air")
+    for (kind, direction), (count, total) in sorted(records.items()):
+        print("%s,%s,%d,%d" % (kind, direction, count, total))
+    if uplinks:
+        app = sum(t for (k, d), (c, t) in records.items() if d == "up" and k in ("application_data", "tls12_cid"))
+        all_bytes = sum(t for _, (c, t) in records.items())
+        print("uplinks %d, %.1f bytes per uplink record, %.1f bytes per uplink including handshakes and replies"
+              % (uplinks, app / uplinks, all_bytes / uplinks))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--payload", default=PAYLOAD, help="uplink payload string")
+    parser.add_argument("--uplinks", type=int, default=1, help="uplinks per handshake")
+    parser.add_argument("--cid", type=int, default=2, help="Connection ID length in bytes")
+    parser.add_argument("--pcap", help="capture of the stand-in server")
+    parser.add_argument("--port", type=int, default=5684)
+    args = parser.parse_args()
+
+    if args.pcap:
+        measure(args.pcap, args.port)
+    else:
+        model(len(args.payload.encode()), args.uplinks, args.cid)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,29 @@
+#!/bin/bash -xe
+
+# Local stand-in DTLS server for CONFIG_UDP_DTLS_ENABLE (PSK, Connection ID)
+# usage: ./tools/dtls_server.sh <psk identity> <psk hex> [port]
+#
+# Uses mbedTLS ssl_server2 (programs/ssl, built with MBEDTLS_SSL_DTLS_CONNECTION_ID)
+# when found, otherwise openssl s_server, which does not support Connection ID.
+# Capture the traffic for tools/dtls_overhead.py with
+#   tcpdump -i any -w dtls.pcap udp port 5684
+
+SSL_SERVER2=${SSL_SERVER2:-ssl_server2}
+PORT=5684
+
+if [ -z "$2" ]; then
+    echo "usage: $0 <psk identity> <psk hex> [port]"
+    exit 1
+fi
+
+if [ -n "$3" ]; then
+    PORT="$3"
+fi
+
+if command -v $SSL_SERVER2 > /dev/null; then
+    exec $SSL_SERVER2 dtls=1 server_port=$PORT psk_identity="$1" psk="$2" \
+        force_ciphersuite=TLS-PSK-WITH-AES-128-CCM-8 cid=1 cid_val=c1d0 \
+        exchanges=1000000 read_timeout=0 debug_level=1
+fi
+
+exec openssl s_server -dtls1_2 -nocert -accept $PORT -psk_identity "$1" -psk "$2" -cipher PSK-AES128-CCM8
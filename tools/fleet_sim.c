@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//MXPW[̃t[gV~[V (zXgp)
+//dȂǂőS[ɋN̑M1bPʂŏWvA
+//] (N)AICCIDʑ+Wb^AT[owXbg̃s[NM[grB
+//ʑEWb^̌vZɂ src/schedule.c ̂܂܎gB
+//
+//  ./tools/fleet_sim.sh                          (10000 50Z 1 WDT0)
+//  ./tools/fleet_sim.sh -n 3000 -c 20 -w 2 -t 7200
+//
+//  -n [  -c Z  -w NWDT (0`4A]1/2/4/8҂)  -t (b)
+//
+//IR[h 0:Ũs[N]Ⴂ 1:ႭȂ 2:G[
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "schedule.h"
+
+#define PERIOD_MS 116000      //CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS
+#define BOOT_JITTER_MS 60000  //CONFIG_UDP_SCHEDULE_BOOT_JITTER_SECONDS
+#define ATTACH_MIN_MS 2000    //LTEڑv (ŒZ)
+#define ATTACH_RANGE_MS 8000  //LTEڑv (΂)
+#define SENSE_MIN_MS 8000     //Jn瑗M܂ł̏v (vEAT擾)
+#define SENSE_RANGE_MS 2000   // ΂
+#define POST_MS 1000          //M玟̃XPW[܂ł̏v (_EN҂)
+#define CLOCK_ERROR_MS 1000   //[v (AT+CCLK? bP) ̌덷
+
+enum strategy {
+	STRATEGY_LOCKSTEP, //] N
+	STRATEGY_PHASE,    //ICCIDʑ + Wb^
+	STRATEGY_SLOT,     //T[owXbg (񑗐M̏1b蓖)
+	STRATEGY_COUNT,
+};
+
+static const char *const strategy_name[] = { "lockstep", "iccid phase", "server slot" };
+
+static const int wdt_sleep_min[] = { 0, 1, 2, 4, 8 }; //src/main.c Ɠ
+
+static int devices = 10000;
+static int cells = 50;
+static int wdt_count;
+static int duration_s = 3600;
+static uint32_t rng_state = 1;
+
+static uint32_t *tx_total;  //1bƂ̑M
+static uint32_t *tx_cell;   //ZE1bƂ̑M
+static uint32_t *attach;    //1bƂLTEڑ
+static int64_t *first_send; //񑗐M (T[owXbg̊蓖ď)
+static uint32_t *slot_ms;
+
+//sys_rand32_get ̑ (xorshift32)
+static uint32_t rand32(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static void count_tx(int device, int64_t t_ms)
+{
+	int s = t_ms / 1000;
+
+	if (s >= 0 && s < duration_s) {
+		tx_total[s]++;
+		tx_cell[(size_t)(device % cells) * duration_s + s]++;
+	}
+}
+
+//1䕪̑M߂
+static void simulate(enum strategy strategy, int device)
+{
+	char iccid[20];
+	uint32_t phase_ms, sleep_ms;
+	int64_t t, clock_error;
+	bool slot_known = false;
+
+	snprintf(iccid, sizeof(iccid), "898104%013d", device);
+	phase_ms = schedule_phase_ms(iccid, PERIOD_MS);
+	clock_error = (int64_t)(rand32() % (2 * CLOCK_ERROR_MS + 1)) - CLOCK_ERROR_MS;
+
+	//N̑҂
+	if (strategy == STRATEGY_LOCKSTEP) {
+		sleep_ms = wdt_sleep_min[wdt_count] * 60000;
+	} else if (wdt_count > 0) {
+		sleep_ms = schedule_jitter_ms(wdt_sleep_min[wdt_count] * 60000, rand32());
+	} else {
+		sleep_ms = rand32() % (BOOT_JITTER_MS + 1);
+	}
+	t = sleep_ms + ATTACH_MIN_MS + rand32() % ATTACH_RANGE_MS;
+	if (t / 1000 < duration_s) {
+		attach[t / 1000]++;
+	}
+
+	//񑗐M͐ڑAȍ~͎
+	while (t < (int64_t)duration_s * 1000) {
+		t += SENSE_MIN_MS + rand32() % SENSE_RANGE_MS;
+		count_tx(device, t);
+		if (strategy == STRATEGY_SLOT) {
+			slot_known = true; //񑗐M̃_ENŊ蓖
+		} else if (first_send[device] < 0) {
+			first_send[device] = t;
+		}
+		t += POST_MS;
+		if (strategy == STRATEGY_LOCKSTEP) {
+			t += PERIOD_MS;
+		} else {
+			t += schedule_next_ms(t + clock_error, slot_known ? slot_ms[device] : phase_ms, PERIOD_MS,
+			                      PERIOD_MS / 2); //src/main.c Ɠ
+		}
+	}
+}
+
+static int compare_device(const void *a, const void *b)
+{
+	int64_t ta = first_send[*(const int *)a];
+	int64_t tb = first_send[*(const int *)b];
+
+	return (ta > tb) - (ta < tb);
+}
+
+//T[o 񑗐M̏1bMʒu蓖Ă (tools/ingest.py --slots Ɠ)
+static void assign_slots(void)
+{
+	int *order = malloc(devices * sizeof(int));
+	int a;
+
+	for (a = 0; a < devices; a++) {
+		order[a] = a;
+	}
+	qsort(order, devices, sizeof(int), compare_device);
+	for (a = 0; a < devices; a++) {
+		slot_ms[order[a]] = (uint32_t)(a % (PERIOD_MS / 1000)) * 1000;
+	}
+	free(order);
+}
+
+//s[NM [from_s, duration_s)
+static uint32_t peak(const uint32_t *hist, int from_s)
+{
+	uint32_t max = 0;
+	int s;
+
+	for (s = from_s; s < duration_s; s++) {
+		max = hist[s] > max ? hist[s] : max;
+	}
+	return max;
+}
+
+static uint32_t run(enum strategy strategy)
+{
+	uint32_t cell_peak = 0, cell_peak_steady = 0, p;
+	int steady_s = duration_s / 2;
+	int a;
+
+	memset(tx_total, 0, duration_s * sizeof(uint32_t));
+	memset(tx_cell, 0, (size_t)cells * duration_s * sizeof(uint32_t));
+	memset(attach, 0, duration_s * sizeof(uint32_t));
+	if (strategy != STRATEGY_SLOT) {
+		for (a = 0; a < devices; a++) {
+			first_send[a] = -1;
+		}
+	}
+
+	rng_state = 1;
+	for (a = 0; a < devices; a++) {
+		simulate(strategy, a);
+	}
+	for (a = 0; a < cells; a++) {
+		p = peak(&tx_cell[(size_t)a * duration_s], 0);
+		cell_peak = p > cell_peak ? p : cell_peak;
+		p = peak(&tx_cell[(size_t)a * duration_s], steady_s);
+		cell_peak_steady = p > cell_peak_steady ? p : cell_peak_steady;
+	}
+
+	printf("%-12s %10u %10u %10u %10u %10u %10.1f\n", strategy_name[strategy],
+	       peak(attach, 0), peak(tx_total, 0), cell_peak, peak(tx_total, steady_s), cell_peak_steady,
+	       (double)devices * 1000 / PERIOD_MS);
+
+	return peak(tx_total, 0);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t lockstep, phase, slot;
+	int a;
+
+	for (a = 1; a + 1 < argc; a += 2) {
+		if (strcmp(argv[a], "-n") == 0) {
+			devices = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-c") == 0) {
+			cells = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-w") == 0) {
+			wdt_count = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-t") == 0) {
+			duration_s = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || devices <= 0 || cells <= 0 || duration_s <= 0 || wdt_count < 0 || wdt_count > 4) {
+		fprintf(stderr, "usage: %s [-n devices] [-c cells] [-w wdt count 0-4] [-t seconds]\n", argv[0]);
+		return 2;
+	}
+
+	tx_total = malloc(duration_s * sizeof(uint32_t));
+	tx_cell = malloc((size_t)cells * duration_s * sizeof(uint32_t));
+	attach = malloc(duration_s * sizeof(uint32_t));
+	first_send = malloc(devices * sizeof(int64_t));
+	slot_ms = malloc(devices * sizeof(uint32_t));
+
+	printf("devices %d cells %d wdt count %d duration %ds period %ds\n",
+	       devices, cells, wdt_count, duration_s, PERIOD_MS / 1000);
+	printf("%-12s %10s %10s %10s %10s %10s %10s\n", "strategy",
+	       "attach/s", "tx/s", "cell tx/s", "tx/s 2nd", "cell 2nd", "mean tx/s");
+	lockstep = run(STRATEGY_LOCKSTEP);
+	phase = run(STRATEGY_PHASE);
+	assign_slots(); //ICCIDʑ̏񑗐MŊ蓖 (T[owXbgN͓)
+	slot = run(STRATEGY_SLOT);
+	printf("peak reduction: iccid phase %.1fx, server slot %.1fx\n",
+	       (double)lockstep / phase, (double)lockstep / slot);
+
+	return phase < lockstep && slot < lockstep ? 0 : 1;
+}
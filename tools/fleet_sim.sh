@@ -0,0 +1,11 @@
+#!/bin/bash -xe
+
+# Simulate the transmit schedule of a fleet rebooting at once, with src/schedule.c on the host
+# usage: ./tools/fleet_sim.sh [-n devices] [-c cells] [-w wdt count 0-4] [-t seconds]
+
+BUILD_DIR=build/host
+
+mkdir -p $BUILD_DIR
+cc -O2 -Wall -Iinclude -o $BUILD_DIR/fleet_sim tools/fleet_sim.c src/schedule.c
+
+$BUILD_DIR/fleet_sim "$@"
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 SAKURA internet Inc.
+#
+# SPDX-License-Identifier: MIT
+#
+# Local FOTA server for the UDP chunk protocol implemented in src/fota.c.
+#
+#   ./tools/fota_server.py build/scm-ltem1nrf_nrf9160_ns/production/zephyr/app_update.bin
+#
+# Devices request "FOTA,<iccid>,<version>,<image crc>,<offset>" and receive
+# a 24 byte header followed by up to --chunk bytes of the image.
+
+import argparse
+import socket
+import struct
+import zlib
+
+HDR = struct.Struct("<2sBBIIIHHI")
+STATUS_CHUNK = 0
+STATUS_NO_UPDATE = 1
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("image", help="MCUboot signed update image (app_update.bin)")
+    parser.add_argument("--version", required=True, help="version string of the image")
+    parser.add_argument("--port", type=int, default=1235)
+    parser.add_argument("--chunk", type=int, default=512)
+    parser.add_argument("--iccid", action="append", help="limit update to these ICCIDs")
+    args = parser.parse_args()
+
+    image = open(args.image, "rb").read()
+    image_crc = zlib.crc32(image)
+    print(f"image {args.image} size {len(image)} crc {image_crc:08x}")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", args.port))
+
+    while True:
+        data, addr = sock.recvfrom(256)
+        try:
+            tag, iccid, version, _crc, offset = data.decode().split(",")
+            offset = int(offset)
+        except ValueError:
+            continue
+        if tag != "FOTA":
+            continue
+
+        if version == args.version or (args.iccid and iccid not in args.iccid):
+            sock.sendto(HDR.pack(b"FW", STATUS_NO_UPDATE, 0, 0, 0, 0, 0, 0, 0), addr)
+            continue
+
+        chunk = image[offset:offset + args.chunk]
+        header = HDR.pack(b"FW", STATUS_CHUNK, 0, len(image), image_crc, offset, len(chunk), 0, zlib.crc32(chunk))
+        sock.sendto(header + chunk, addr)
+        print(f"{addr[0]} {iccid} {version} offset {offset}/{len(image)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,482 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 SAKURA internet Inc.
+#
+# SPDX-License-Identifier: MIT
+#
+# UDP ingest for the water level gauge.
+#
+# Receives the CSV uplinks sent by src/main.c, converts them to water level
+# with a per-device calibration table (ICCID -> all height, sensor offset,
+# sensor type) and writes InfluxDB line protocol in batches.
+#
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink http://127.0.0.1:8086/write?db=database
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink file:udplog.lp
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink file:/dev/null --bench 10000
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink file:udplog.lp --fota-request 8981040000001220198
+#
+# --fota-request answers the next uplink of that device with a FOTA downlink, so that it
+# downloads the image served by tools/fota_server.py (CONFIG_UDP_FOTA_ENABLE).
+#
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink file:udplog.lp --trace-request 8981040000001220198
+#
+# --trace-request answers the next uplink of that device with a TRACE downlink and saves
+# the traces it sends back (CONFIG_UDP_TRACE_ENABLE) as <trace-dir>/<iccid>_<slot>.bin.
+#
+#   ./tools/ingest.py --calibration tools/calibration.csv --sink file:udplog.lp --slots
+#
+# --slots answers the first uplink of each device with a SLOT downlink, assigning the
+# transmission offsets round robin one second apart within --period (see tools/fleet_sim.sh).
+# The SLOT downlink is sent again when the uplink count goes back (the device restarted and
+# may have lost its slot) and every --slot-every uplinks (the downlink may have been lost).
+#
+# Uplinks carrying the boot count and sequence number (src/seqno.c) go through a per-device
+# delivery tracker: duplicates are dropped, and the loss rate over the last --seq-window
+# sequence numbers and the lost / duplicate / reordered / reboot counts are added to each point.
+#
+# --store also writes the values to the local columnar store of tools/tsstore.py, with or
+# without an InfluxDB sink.
+
+import argparse
+import csv
+import os
+import random
+import socket
+import sys
+import time
+import urllib.parse
+import urllib.request
+
+import tsstore
+
+# Same rules as the Node-RED function node
+MIN_DISTANCE_MM = (300, 500)  # 0:5m sensor, 1:10m sensor (readings at or below are errors, as in src/ranging.c)
+MEDIAN_WINDOW_MM = 60         # readings this far or further from the median are dropped
+MIN_LEVEL_MM = -100
+SEQNO_RESERVE = 256           # src/seqno.h: numbers skipped at most after a power loss
+
+
+class Device:
+    __slots__ = ("name", "all_height", "offset", "sensor_type", "max_level")
+
+    def __init__(self, name, all_height, offset, sensor_type, max_level):
+        self.name = name
+        self.all_height = all_height
+        self.offset = offset
+        self.sensor_type = sensor_type
+        self.max_level = max_level
+
+
+def load_calibration(path):
+    table = {}
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            table[row["iccid"]] = Device(row["name"], int(row["all_height_mm"]), int(row["sensor_offset_mm"]),
+                                         int(row["sensor_type"]), int(row["max_level_mm"]))
+    return table
+
+
+def reliable_distance(distances, sensor_type):
+    """Median filtered mean of the valid readings, or None."""
+    limit = MIN_DISTANCE_MM[1 if sensor_type == 1 else 0]
+    valid = sorted(d for d in distances if d > limit)
+    n = len(valid)
+    if n == 0:
+        return None, None, 0, 0
+    median = valid[n // 2] if n % 2 else (valid[n // 2 - 1] + valid[n // 2]) / 2
+    kept = [d for d in valid if abs(d - median) < MEDIAN_WINDOW_MM]
+    return round(sum(kept) / len(kept)), median, n, len(kept)
+
+
+def escape_tag(value):
+    """Escapes a tag value for line protocol (backslash, comma, equals sign and space)."""
+    return value.replace("\\", "\\\\").replace(",", "\\,").replace("=", "\\=").replace(" ", "\\ ")
+
+
+def to_int(value, base=10, default=0):
+    try:
+        return int(value, base)
+    except ValueError:
+        return default
+
+
+class Delivery:
+    __slots__ = ("boot", "top", "base", "seen", "in_window", "lost", "dup", "reorder", "late", "skipped", "reboots")
+
+    def __init__(self, boot, seq, window):
+        self.boot = boot
+        self.top = seq          # highest sequence number received
+        self.base = seq         # first sequence number tracked
+        self.seen = [None] * window
+        self.in_window = 0      # received numbers in (top - window, top]
+        self.lost = 0
+        self.dup = 0
+        self.reorder = 0
+        self.late = 0
+        self.skipped = 0
+        self.reboots = 0
+
+
+class DeliveryTracker:
+    """Per-device sliding window over the uplink sequence numbers, at most `window` steps per uplink."""
+
+    def __init__(self, window):
+        self.window = window
+        self.devices = {}  # ICCID -> Delivery
+
+    def update(self, iccid, boot, seq):
+        """Counts one uplink. Returns the statistics fields, or None for a duplicate."""
+        w = self.window
+        d = self.devices.get(iccid)
+        if d is None or boot < d.boot:
+            # first uplink, or the boot count went back because the settings were erased
+            # (flashed again or the board replaced): the old numbers no longer apply
+            d = self.devices[iccid] = Delivery(boot, seq, w)
+            d.seen[seq % w] = seq
+            d.in_window = 1
+        else:
+            rebooted = boot > d.boot
+            if rebooted:
+                d.reboots += boot - d.boot
+                d.boot = boot
+            if seq > d.top:
+                gap = seq - d.top - 1
+                if rebooted and gap <= SEQNO_RESERVE:
+                    d.skipped += gap  # a cold boot resumes from the reserved number, or a loss: unknown
+                else:
+                    d.lost += gap
+                # clear the slots the window moves over (min(gap + 1, window) steps)
+                for n in range(max(d.top + 1, seq - w + 1), seq + 1):
+                    if d.seen[n % w] == n - w:
+                        d.in_window -= 1
+                    d.seen[n % w] = None
+                if seq - d.top >= w:
+                    d.in_window = 0
+                d.seen[seq % w] = seq
+                d.in_window += 1
+                d.top = seq
+            elif seq <= d.top - w or seq < d.base:
+                d.late += 1
+            elif d.seen[seq % w] == seq:
+                d.dup += 1
+                return None
+            else:
+                d.seen[seq % w] = seq
+                d.in_window += 1
+                d.reorder += 1
+                if d.lost > 0:
+                    d.lost -= 1  # counted as lost when the gap was seen
+                else:
+                    d.skipped -= 1
+        expected = min(w, d.top - d.base + 1)
+        return {
+            "SeqLossRate": max(0.0, 1 - d.in_window / expected),
+            "SeqLost": d.lost,
+            "SeqDup": d.dup,
+            "SeqReorder": d.reorder,
+            "SeqLate": d.late,
+            "SeqSkipped": d.skipped,
+            "Reboots": d.reboots,
+        }
+
+
+def convert(fields, table, measurement, now_ms, tracker=None, store=None):
+    """One uplink (CSV fields) to one line of line protocol, or None (also for a duplicate)."""
+    if len(fields) < 21:
+        return None
+    iccid = fields[2]
+    distances = [to_int(v) for v in fields[5:10]]
+    sensor_type = to_int(fields[19])
+    es = to_int(fields[15])
+
+    values = {
+        "BATT": to_int(fields[3]),
+        "TEMP": round(float(fields[4]) * 10) / 10,
+        "Distance1": distances[0],
+        "Distance2": distances[1],
+        "Distance3": distances[2],
+        "Distance4": distances[3],
+        "Distance5": distances[4],
+        "Count": to_int(fields[10]),
+        "Band": to_int(fields[11]),
+        "Plmn": to_int(fields[12]),
+        "Tac": to_int(fields[13], 16),
+        "Cell_ID": to_int(fields[14], 16),
+        "ES": es,
+        "SensorType": sensor_type,
+        "Retry": to_int(fields[20]),
+        "Alarm": to_int(fields[21]) if len(fields) > 21 else 0,
+    }
+    if len(fields) > 25:
+        values["LinkSocket"] = to_int(fields[22])
+        values["LinkRegWait"] = to_int(fields[23])
+        values["LinkCfun"] = to_int(fields[24])
+        values["LinkReset"] = to_int(fields[25])
+    if len(fields) > 27:
+        values["Boot"] = to_int(fields[26])
+        values["Seq"] = to_int(fields[27])
+        if tracker is not None:
+            stats = tracker.update(iccid, values["Boot"], values["Seq"])
+            if stats is None:
+                return None
+            values.update(stats)
+    if len(fields) > 30:
+        values["DeferCount"] = to_int(fields[28])
+        values["DeferForced"] = to_int(fields[29])
+        values["DeferSaved"] = to_int(fields[30])
+    if es >= 5:
+        values["RSRP"] = to_int(fields[16]) - 140
+        values["RSRQ"] = to_int(fields[17]) / 2 - 19.5
+        values["SNR"] = to_int(fields[18]) - 24
+
+    device = table.get(iccid)
+    if device is not None and device.sensor_type >= 0:
+        sensor_type = device.sensor_type
+    if len(fields) > 31:
+        # temperature compensated and filtered on the device
+        distance = to_int(fields[31], default=-1)
+        distance = distance if distance >= 0 else None
+        values["DistanceValid"] = sum(1 for d in distances if d > MIN_DISTANCE_MM[1 if sensor_type == 1 else 0])
+    else:
+        distance, median, n_valid, n_kept = reliable_distance(distances, sensor_type)
+        values["DistanceValid"] = n_valid
+        values["DistanceReliable"] = n_kept
+        if distance is not None:
+            values["DistanceMedian"] = median
+    if distance is not None:
+        values["Distance"] = distance
+        if device is not None:
+            level = device.all_height - (distance + device.offset)
+            if MIN_LEVEL_MM <= level <= device.max_level:
+                values["WaterLevel"] = level
+    if store is not None:
+        store.append(iccid, now_ms, values)
+
+    tags = "ICCID=" + escape_tag(iccid)
+    if device is not None:
+        tags += ",Name=" + escape_tag(device.name)
+    body = ",".join(k + "=" + (str(v) + "i" if isinstance(v, int) else repr(float(v))) for k, v in values.items())
+    return "%s,%s %s %d\n" % (measurement, tags, body, now_ms)
+
+
+class Sink:
+    """Line protocol batch writer flushed by size or age."""
+
+    def __init__(self, url, max_bytes, max_age):
+        self.url = url
+        self.max_bytes = max_bytes
+        self.max_age = max_age
+        self.buf = []
+        self.size = 0
+        self.first = 0.0
+        self.file = None
+        self.sock = None
+        if url.startswith("file:"):
+            self.file = open(url[5:], "a")
+        elif url.startswith("udp:"):
+            host, port = url[4:].rsplit(":", 1)
+            self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            self.sock.connect((host, int(port)))
+        elif url.startswith("http"):
+            # InfluxDB write URL with precision=ms added to any query it already has
+            parts = urllib.parse.urlsplit(url)
+            query = [(k, v) for k, v in urllib.parse.parse_qsl(parts.query) if k != "precision"]
+            query.append(("precision", "ms"))
+            self.url = urllib.parse.urlunsplit(parts._replace(query=urllib.parse.urlencode(query)))
+        else:
+            raise ValueError("unknown sink " + url)
+
+    def write(self, line, now):
+        if not self.buf:
+            self.first = now
+        self.buf.append(line)
+        self.size += len(line)
+        if self.size >= self.max_bytes:
+            self.flush()
+
+    def poll(self, now):
+        if self.buf and now - self.first >= self.max_age:
+            self.flush()
+
+    def flush(self):
+        if not self.buf:
+            return
+        chunk = "".join(self.buf)
+        self.buf = []
+        self.size = 0
+        if self.file is not None:
+            self.file.write(chunk)
+            self.file.flush()
+        elif self.sock is not None:
+            self.sock.send(chunk.encode())
+        else:
+            req = urllib.request.Request(self.url, data=chunk.encode(), method="POST")
+            try:
+                urllib.request.urlopen(req, timeout=10).close()
+            except OSError as e:
+                print("write failed: %s" % e, file=sys.stderr)
+
+
+class TraceCollector:
+    """Requests traces with a TRACE downlink and reassembles the TR datagrams sent back."""
+
+    def __init__(self, iccids, directory):
+        self.pending = set(iccids)
+        self.directory = directory
+        self.requested = {}  # address -> ICCID
+        self.parts = {}      # (address, slot) -> {part: data}
+
+    def uplink(self, sock, iccid, addr):
+        if iccid in self.pending:
+            self.pending.discard(iccid)
+            self.requested[addr] = iccid
+            sock.sendto(b"TRACE", addr)
+            print("trace requested from %s" % iccid, file=sys.stderr)
+
+    def datagram(self, data, addr):
+        """True when `data` is a trace datagram ('T','R',slot,part,parts,data)."""
+        if len(data) < 5 or data[:2] != b"TR" or addr not in self.requested:
+            return False
+        slot, part, parts = data[2], data[3], data[4]
+        chunks = self.parts.setdefault((addr, slot), {})
+        chunks[part] = data[5:]
+        if len(chunks) == parts:
+            path = os.path.join(self.directory, "%s_%d.bin" % (self.requested[addr], slot))
+            with open(path, "wb") as f:
+                f.write(b"".join(chunks[i] for i in range(parts)))
+            del self.parts[(addr, slot)]
+            print("trace saved %s" % path, file=sys.stderr)
+        return True
+
+
+class SlotAssigner:
+    """Assigns each device a transmission offset with a SLOT downlink, and repeats it until it sticks."""
+
+    def __init__(self, period, every):
+        self.period = period
+        self.every = every
+        self.assigned = {}  # ICCID -> offset seconds
+        self.count = {}     # ICCID -> uplink count of the last uplink
+        self.since = {}     # ICCID -> uplinks since the last SLOT downlink
+
+    def uplink(self, sock, iccid, addr, count):
+        if iccid not in self.assigned:
+            self.assigned[iccid] = len(self.assigned) % self.period
+        since = self.since.get(iccid, self.every - 1) + 1
+        if since >= self.every or count < self.count.get(iccid, 0):
+            sock.sendto(b"SLOT,%d" % self.assigned[iccid], addr)
+            since = 0
+        self.count[iccid] = count
+        self.since[iccid] = since
+
+
+def bench(table, sink, measurement, devices, messages, tracker):
+    """Synthetic uplinks from `devices` gauges through convert() and the sink."""
+    iccids = ["89810400%011d" % i for i in range(devices)]
+    for i, iccid in enumerate(iccids):
+        if iccid not in table:
+            table[iccid] = Device("B%d" % i, 3000, 0, -1, 3000)
+    rng = random.Random(1)
+    lines = []
+    for i in range(min(messages, 1000)):
+        d = [rng.randint(1000, 2000) for _ in range(5)]
+        lines.append('23/10/18,12:00:00+36,%s,3600,+21.50,%d,%d,%d,%d,%d,%010d,18,"44020","185C","008AAA5C",6,42,20,30,0,00,0,0,0,0,0,1,0,0,0,0,%d'
+                     % (iccids[i % devices], d[0], d[1], d[2], d[3], d[4], i, sorted(d)[2]))
+    start = time.perf_counter()
+    for i in range(messages):
+        fields = next(csv.reader([lines[i % len(lines)]]))
+        fields[2] = iccids[i % devices]
+        fields[27] = str(i // devices)
+        now = time.perf_counter()
+        sink.write(convert(fields, table, measurement, int(time.time() * 1000), tracker), now)
+        sink.poll(now)
+    sink.flush()
+    elapsed = time.perf_counter() - start
+    print("devices %d messages %d elapsed %.3fs %.0f msg/s %.2f us/msg"
+          % (devices, messages, elapsed, messages / elapsed, elapsed * 1e6 / messages))
+
+
+class FotaRequester:
+    """Starts the firmware download of each listed device with a FOTA downlink on its next uplink."""
+
+    def __init__(self, iccids):
+        self.pending = set(iccids)
+
+    def uplink(self, sock, iccid, addr):
+        if iccid in self.pending:
+            self.pending.discard(iccid)
+            sock.sendto(b"FOTA", addr)
+            print("FOTA requested from %s" % iccid, file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--calibration", required=True, help="CSV calibration table")
+    parser.add_argument("--sink", help="file:<path>, udp:<host>:<port> or InfluxDB http write URL")
+    parser.add_argument("--store", metavar="DIR", help="also write to the columnar store in DIR (tools/tsstore.py)")
+    parser.add_argument("--port", type=int, default=1234)
+    parser.add_argument("--measurement", default="TEST")
+    parser.add_argument("--batch-bytes", type=int, default=64 * 1024)
+    parser.add_argument("--batch-seconds", type=float, default=5.0)
+    parser.add_argument("--trace-request", action="append", default=[], metavar="ICCID",
+                        help="request the stored traces of this device with its next uplink")
+    parser.add_argument("--trace-dir", default=".")
+    parser.add_argument("--slots", action="store_true", help="assign transmission offsets to the devices")
+    parser.add_argument("--period", type=int, default=116, help="CONFIG_UDP_DATA_UPLOAD_FREQUENCY_SECONDS")
+    parser.add_argument("--slot-every", type=int, default=30, metavar="UPLINKS",
+                        help="repeat the SLOT downlink every this many uplinks")
+    parser.add_argument("--seq-window", type=int, default=1024, help="sequence numbers in the loss rate window")
+    parser.add_argument("--bench", type=int, metavar="DEVICES", help="run the synthetic benchmark")
+    parser.add_argument("--bench-messages", type=int, default=200000)
+    parser.add_argument("--fota-request", action="append", default=[], metavar="ICCID",
+                        help="start the firmware download of this device with its next uplink")
+    args = parser.parse_args()
+
+    if args.sink is None and args.store is None:
+        parser.error("--sink or --store is required")
+    table = load_calibration(args.calibration)
+    sink = Sink(args.sink or "file:" + os.devnull, args.batch_bytes, args.batch_seconds)
+    store = tsstore.Store(args.store) if args.store else None
+    store_flushed = time.monotonic()
+    tracker = DeliveryTracker(args.seq_window)
+
+    if args.bench:
+        bench(table, sink, args.measurement, args.bench, args.bench_messages, tracker)
+        return
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", args.port))
+    sock.settimeout(args.batch_seconds)
+    fota = FotaRequester(args.fota_request)
+    traces = TraceCollector(args.trace_request, args.trace_dir)
+    slots = SlotAssigner(args.period, args.slot_every) if args.slots else None
+    while True:
+        try:
+            data, addr = sock.recvfrom(1024)
+        except socket.timeout:
+            data = None
+        now = time.monotonic()
+        if store is not None and now - store_flushed >= args.batch_seconds:
+            store.flush()
+            store_flushed = now
+        if data is None:
+            sink.poll(now)
+            continue
+        if traces.datagram(data, addr):
+            continue
+        try:
+            fields = next(csv.reader([data.decode()]))
+            line = convert(fields, table, args.measurement, int(time.time() * 1000), tracker, store)
+        except (ValueError, StopIteration):
+            line = None
+        if line is not None:
+            sink.write(line, now)
+            traces.uplink(sock, fields[2], addr)
+            fota.uplink(sock, fields[2], addr)
+            if slots is not None:
+                slots.uplink(sock, fields[2], addr, to_int(fields[10]))
+        sink.poll(now)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,24 @@
+#!/bin/bash -xe
+
+# Decode dictionary logging output captured over RTT
+# usage: ./tools/log_decode.sh <rtt capture file> [target] [board]
+
+TARGET_BOARD=scm-ltem1nrf_nrf9160_ns
+TARGET_ENV=production
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <rtt capture file> [target] [board]"
+    exit 1
+fi
+
+if [ -n "$2" ]; then
+    TARGET_ENV="$2"
+fi
+
+if [ -n "$3" ]; then
+    TARGET_BOARD="$3"
+fi
+
+BUILD_DIR=build/$TARGET_BOARD/$TARGET_ENV/
+
+python3 $ZEPHYR_BASE/scripts/logging/dictionary/log_parser.py $BUILD_DIR/zephyr/log_dictionary.json "$1"
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 SAKURA internet Inc.
+#
+# SPDX-License-Identifier: MIT
+#
+# Compare the PROFILE lines of two RTT logs (CONFIG_UDP_PROFILE_ENABLE),
+# or two results of the host benchmark (tools/bench.sh).
+#
+#   JLinkRTTLogger ... base.log   (firmware built from the base commit)
+#   JLinkRTTLogger ... new.log    (firmware built from the new commit)
+#   ./tools/profile_diff.py base.log new.log
+#
+#   ./tools/bench.sh > base.csv   (host benchmark, step,ns_per_op,stack_bytes)
+#   ./tools/bench.sh > new.csv
+#   ./tools/profile_diff.py base.csv new.csv
+#
+# The last report of each log is used, since the averages are cumulative.
+# The stack usage of the benchmark is compared as step "<step>.stack".
+# Output is CSV: step,base_ns,new_ns,delta_percent
+
+import sys
+
+
+def load(path):
+    steps = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            fields = line.split(",")
+            if len(fields) == 3 and fields[0] != "step" and not line.startswith("PROFILE,"):
+                steps[fields[0]] = float(fields[1])
+                steps[fields[0] + ".stack"] = int(fields[2])
+                continue
+            if not line.startswith("PROFILE,"):
+                continue
+            if fields[1] == "stack_unused":
+                steps["stack_unused"] = int(fields[2])
+            elif len(fields) == 8:
+                steps[fields[1]] = int(fields[7])
+    return steps
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: %s <base log> <new log>" % sys.argv[0], file=sys.stderr)
+        sys.exit(2)
+    base = load(sys.argv[1])
+    new = load(sys.argv[2])
+
+    print("step,base_ns,new_ns,delta_percent")
+    for step in list(base) + [s for s in new if s not in base]:
+        b = base.get(step)
+        n = new.get(step)
+        delta = "" if not b or n is None else "%+.1f" % ((n - b) * 100.0 / b)
+        print("%s,%s,%s,%s" % (step, "" if b is None else b, "" if n is None else n, delta))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+#!/bin/bash -e
+
+# Build each prj.conf variant with the DIP switch override and with a fixed Kconfig profile,
+# and compare the image sizes of zephyr.elf
+# usage: ./tools/profile_size.sh [board] [targets...]
+
+TARGET_BOARD=scm-ltem1nrf_nrf9160_ns
+TARGETS="develop staging production"
+
+if [ -n "$1" ]; then
+    TARGET_BOARD="$1"
+    shift
+fi
+if [ -n "$1" ]; then
+    TARGETS="$*"
+fi
+
+SIZE_DIR=build/size
+
+# text data bss of zephyr.elf, with the size tool of the toolchain used for the build
+elf_size() {
+    local dir=$1
+    local objcopy=$(sed -n 's/^CMAKE_OBJCOPY:FILEPATH=//p' $dir/CMakeCache.txt)
+    local size=${objcopy%objcopy}size
+
+    if [ ! -x "$size" ]; then
+        size=size
+    fi
+    $size $dir/zephyr/zephyr.elf | awk 'NR == 2 { print $1, $2, $3 }'
+}
+
+build() {
+    local env=$1
+    local variant=$2
+    local dir=$SIZE_DIR/$TARGET_BOARD/$env/$variant
+
+    mkdir -p $dir
+    cat prj.conf.base prj.conf.$env > prj.conf
+    if [ "$variant" = "fixed" ]; then
+        echo "CONFIG_UDP_DIP_OVERRIDE=n" > $dir/../fixed.conf
+        west build -p always -b $TARGET_BOARD -d $dir -- -DSIPF_ENVIRONMENT=$env \
+            -DOVERLAY_CONFIG=$(pwd)/$dir/../fixed.conf > $dir/../$variant.log
+    else
+        west build -p always -b $TARGET_BOARD -d $dir -- -DSIPF_ENVIRONMENT=$env > $dir/../$variant.log
+    fi
+}
+
+REPORT=""
+for env in $TARGETS; do
+    if [ ! -e "prj.conf.$env" ]; then
+        echo "Invalid environment $env"
+        exit 1
+    fi
+    build $env dip
+    build $env fixed
+    read dip_text dip_data dip_bss <<< $(elf_size $SIZE_DIR/$TARGET_BOARD/$env/dip)
+    read fix_text fix_data fix_bss <<< $(elf_size $SIZE_DIR/$TARGET_BOARD/$env/fixed)
+    REPORT+=$(printf "%-10s %8d %8d %8d %8d %8d %8d %+7d %+7d %+7d" $env \
+        $dip_text $dip_data $dip_bss $fix_text $fix_data $fix_bss \
+        $((fix_text - dip_text)) $((fix_data - dip_data)) $((fix_bss - dip_bss)))$'\n'
+done
+
+printf "%-10s %8s %8s %8s %8s %8s %8s %7s %7s %7s\n" target \
+    "text" "data" "bss" "text" "data" "bss" "text" "data" "bss"
+printf "%-10s %26s %26s %23s\n" "" "DIP override" "fixed profile" "difference"
+printf "%s" "$REPORT"
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023 SAKURA internet Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//g[XĐ (zXgp)
+//[ŋL^g[X (CONFIG_UDP_TRACE_ENABLE)  src/ranging.c, src/at_parse.c ɒʂA
+//[Ɠ茋ʂɂȂ邩mFB-b w肷ƍĐ̎ԂvB
+//
+//  ./tools/trace_replay.sh rtt.log            (TRACE,<Xbg>,<ItZbg>,<16i> ܂ރO)
+//  ./tools/trace_replay.sh trace_0.bin        (_ENŎ擾oCi)
+//  ./tools/trace_replay.sh -b 10000 rtt.log
+//
+//IR[h 0:v 1:sv 2:̓G[
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ranging.h"
+#include "at_parse.h"
+#include "trace.h"
+
+#define TRACE_MAX 4096
+#define TRACE_COUNT_MAX 64
+
+struct trace {
+	char name[64];
+	uint8_t data[TRACE_MAX];
+	size_t len;
+};
+
+static struct trace traces[TRACE_COUNT_MAX];
+static int trace_count;
+static FILE *out; //Đʂ̏o͐ (v/dev/null)
+static int mismatch;
+
+static const char *const event_name[] = {
+	"timeout", "sensing", "retry", "xmonitor_error", "coneval_error", "alarm", "send_error", "link_recovery", "defer",
+};
+
+static const struct ranging_sensor *const sensors[] = { &ranging_mb7389, &ranging_mb7388, &ranging_mb7051 };
+
+//O TRACE,<Xbg>,<ItZbg>,<16i> sǂݍ
+static int load_log(const char *path, FILE *fp)
+{
+	char line[512];
+	struct trace *t = NULL;
+	int slot, offset, n;
+	char *p;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		p = strstr(line, "TRACE,");
+		if (p == NULL || sscanf(p, "TRACE,%d,%d,%n", &slot, &offset, &n) != 2) {
+			continue;
+		}
+		if (offset == 0) {
+			if (trace_count >= TRACE_COUNT_MAX) {
+				break;
+			}
+			t = &traces[trace_count++];
+			snprintf(t->name, sizeof(t->name), "%s:slot%d", path, slot);
+		}
+		if (t == NULL || (size_t)offset != t->len) {
+			fprintf(stderr, "%s: missing TRACE line before slot %d offset %d\n", path, slot, offset);
+			t = NULL;
+			continue;
+		}
+		for (p += n; p[0] && p[1] && p[0] != '\r' && p[0] != '\n' && t->len < TRACE_MAX; p += 2) {
+			unsigned int byte;
+
+			if (sscanf(p, "%2x", &byte) != 1) {
+				break;
+			}
+			t->data[t->len++] = byte;
+		}
+	}
+
+	return 0;
+}
+
+//g[Xt@C̓ǂݍ (oCi܂̓O)
+static int load(const char *path)
+{
+	FILE *fp = fopen(path, "rb");
+	struct trace *t;
+	int c;
+
+	if (fp == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	c = fgetc(fp);
+	rewind(fp);
+	if (c == TRACE_CYCLE && trace_count < TRACE_COUNT_MAX) {
+		t = &traces[trace_count++];
+		snprintf(t->name, sizeof(t->name), "%s", path);
+		t->len = fread(t->data, 1, TRACE_MAX, fp);
+	} else {
+		load_log(path, fp);
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+//L^ꂽ茋ʂƍĐʂ̔r
+static void check(const char *what, int recorded, int replayed)
+{
+	if (recorded != replayed) {
+		fprintf(out, "  MISMATCH %s recorded %d replayed %d\n", what, recorded, replayed);
+		mismatch++;
+	}
+}
+
+//g[X1̍Đ (src/main.c  range_finder_read Ɠ菇Ńt[ϊ)
+static void replay(const struct trace *t)
+{
+	const struct ranging_sensor *sensor = &ranging_mb7389;
+	struct ranging_frame frame;
+	int16_t range_mm[RANGING_FRAME_COUNT];
+	int frames = 0;       //̎sŎMt[ (ǂݎ̂Ă܂)
+	int errors = -1;      //̎švlG[
+	int tries = 0;        //s
+	bool timeout = false; //̎sŃ^CAEg
+	char at_cmd[256] = {0};
+	char resp[256];
+	size_t pos = 0;
+	int a;
+
+	fprintf(out, "trace %s (%zu bytes)\n", t->name, t->len);
+	ranging_frame_reset(&frame);
+
+	while (pos + TRACE_RECORD_HDR_SIZE <= t->len) {
+		uint8_t type = t->data[pos];
+		unsigned int dt = t->data[pos + 1] | (t->data[pos + 2] << 8);
+		size_t len = t->data[pos + 3];
+		const uint8_t *data = &t->data[pos + TRACE_RECORD_HDR_SIZE];
+
+		if (pos + TRACE_RECORD_HDR_SIZE + len > t->len) {
+			fprintf(out, "  truncated record at %zu\n", pos);
+			break;
+		}
+		pos += TRACE_RECORD_HDR_SIZE + len;
+
+		switch (type) {
+		case TRACE_CYCLE:
+			sensor = &ranging_mb7389;
+			for (a = 0; a < (int)(sizeof(sensors) / sizeof(sensors[0])); a++) {
+				if (len - 4 == strlen(sensors[a]->name) && memcmp(&data[4], sensors[a]->name, len - 4) == 0) {
+					sensor = sensors[a];
+				}
+			}
+			fprintf(out, "cycle uptime %u ms sensor %s\n",
+			        data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24), sensor->name);
+			break;
+
+		case TRACE_UART:
+			if (dt > ranging_timeout_ms(sensor) && frames > 0) {
+				timeout = true; //MԊu^CAEg𒴂s͒[ł^CAEgĂ
+			}
+			for (a = 0; a < (int)len && !timeout; a++) {
+				if (!ranging_frame_push(&frame, data[a])) {
+					continue;
+				}
+				if (frames >= sensor->warmup_frames) {
+					range_mm[frames - sensor->warmup_frames] = ranging_convert(sensor, &frame);
+				}
+				ranging_frame_reset(&frame);
+				frames++;
+				if (frames == sensor->warmup_frames + RANGING_FRAME_COUNT) {
+					errors = ranging_error_count(range_mm, RANGING_FRAME_COUNT);
+					fprintf(out, "  try %d [%d,%d,%d,%d,%d] errors %d median %d\n", ++tries,
+					        range_mm[0], range_mm[1], range_mm[2], range_mm[3], range_mm[4],
+					        errors, ranging_median(range_mm, RANGING_FRAME_COUNT));
+					frames = 0;
+				}
+			}
+			break;
+
+		case TRACE_AT_CMD:
+			snprintf(at_cmd, sizeof(at_cmd), "%.*s", (int)len, data);
+			break;
+
+		case TRACE_AT_RESP:
+			snprintf(resp, sizeof(resp), "%.*s", (int)len, data);
+			fprintf(out, "  %s -> %s\n", at_cmd, resp);
+			if (strcmp(at_cmd, "AT%XMONITOR") == 0) {
+				struct xmonitor_info info;
+				bool ok = at_parse_xmonitor(resp, &info);
+
+				fprintf(out, "  xmonitor %s plmn %s tac %s band %s cell %s\n", ok ? "ok" : "error",
+				        info.plmn, info.tac, info.band, info.cell_id);
+			} else if (strcmp(at_cmd, "AT%CONEVAL") == 0) {
+				struct coneval_info info;
+				bool ok = at_parse_coneval(resp, &info);
+
+				fprintf(out, "  coneval %s es %s rsrp %s rsrq %s snr %s\n", ok ? "ok" : "error",
+				        info.es, info.rsrp, info.rsrq, info.snr);
+			}
+			break;
+
+		case TRACE_EVENT: {
+			int event = data[0];
+			int value = (int16_t)(data[1] | (data[2] << 8));
+
+			fprintf(out, "  event %s value %d\n",
+			        event < (int)(sizeof(event_name) / sizeof(event_name[0])) ? event_name[event] : "unknown", value);
+			switch (event) {
+			case TRACE_EV_TIMEOUT:
+				fprintf(out, "  timeout after %d frames\n", frames);
+				check("timeout", 1, timeout || frames < sensor->warmup_frames + RANGING_FRAME_COUNT);
+				check("timeout frames", value, frames);
+				frames = 0;
+				timeout = false;
+				ranging_frame_reset(&frame);
+				break;
+			case TRACE_EV_SENSING:
+				check("sensing errors", value, errors);
+				errors = -1;
+				break;
+			case TRACE_EV_RETRY:
+				check("retry", value, tries - 1);
+				break;
+			default:
+				break;
+			}
+			break;
+		}
+
+		default:
+			fprintf(out, "  unknown record 0x%02x at %zu\n", type, pos);
+			return;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	long bench = 0;
+	struct timespec start, end;
+	double ns;
+	long n;
+	int a;
+
+	for (a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "-b") == 0 && a + 1 < argc) {
+			bench = strtol(argv[++a], NULL, 10);
+		} else if (load(argv[a]) != 0) {
+			return 2;
+		}
+	}
+	if (trace_count == 0) {
+		fprintf(stderr, "usage: %s [-b iterations] <trace file>...\n", argv[0]);
+		return 2;
+	}
+
+	out = stdout;
+	for (a = 0; a < trace_count; a++) {
+		replay(&traces[a]);
+	}
+	printf("%d traces, %d mismatches\n", trace_count, mismatch);
+
+	if (bench > 0) {
+		out = fopen("/dev/null", "w");
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < bench; n++) {
+			for (a = 0; a < trace_count; a++) {
+				replay(&traces[a]);
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+		printf("bench %ld iterations, %.0f ns per trace\n", bench, ns / bench / trace_count);
+	}
+
+	return mismatch ? 1 : 0;
+}
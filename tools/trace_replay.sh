@@ -0,0 +1,16 @@
+#!/bin/bash -xe
+
+# Replay traces recorded with CONFIG_UDP_TRACE_ENABLE through src/ranging.c and src/at_parse.c on the host
+# usage: ./tools/trace_replay.sh [-b iterations] <rtt log or trace file>...
+
+BUILD_DIR=build/host
+
+if [ -z "$1" ]; then
+    echo "usage: $0 [-b iterations] <rtt log or trace file>..."
+    exit 1
+fi
+
+mkdir -p $BUILD_DIR
+cc -O2 -Wall -Iinclude -o $BUILD_DIR/trace_replay tools/trace_replay.c src/ranging.c src/at_parse.c
+
+$BUILD_DIR/trace_replay "$@"
@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 SAKURA internet Inc.
+#
+# SPDX-License-Identifier: MIT
+#
+# Columnar time-series store for the water level gauge uplinks.
+#
+# A local alternative to InfluxDB for the ~20 numeric values each gauge sends every
+# transmission interval. Rows are keyed by ICCID and time (ms) and stored per column:
+#
+#   <root>/<iccid>/<day>/<column>.seg   append-only segment per UTC day and column
+#   <root>/<iccid>/tail.bin             rows not yet sealed into a block
+#
+# A segment is a sequence of blocks of up to BLOCK_ROWS rows. Each block is frame-of-reference
+# compressed: a header (base, width, flags, count) and the offsets from the base as 0/1/2/4/8
+# byte little-endian integers. The top code of the width marks a missing value. Row i of a day is
+# in the same block of every column file, so a query walks the block headers of the time column,
+# bisects the range and decodes only the matching blocks of the requested columns, straight from
+# mmap() of the segment files.
+#
+#   ./tools/tsstore.py query <root> <iccid> --hours 24 --columns distance,batt,temp
+#   ./tools/tsstore.py bench --devices 1000 --hours 24
+#   ./tools/ingest.py --calibration tools/calibration.csv --store <root>
+
+import argparse
+import array
+import bisect
+import mmap
+import os
+import random
+import shutil
+import struct
+import sys
+import tempfile
+import time
+
+BLOCK_ROWS = 128
+DAY_MS = 86400 * 1000
+
+# Column name, ingest.py field, scale (stored as round(value * scale))
+COLUMNS = (
+    ("distance", "Distance", 1),
+    ("level", "WaterLevel", 1),
+    ("distance1", "Distance1", 1),
+    ("distance2", "Distance2", 1),
+    ("distance3", "Distance3", 1),
+    ("distance4", "Distance4", 1),
+    ("distance5", "Distance5", 1),
+    ("batt", "BATT", 1),
+    ("temp", "TEMP", 100),
+    ("rsrp", "RSRP", 1),
+    ("rsrq", "RSRQ", 2),
+    ("snr", "SNR", 1),
+    ("es", "ES", 1),
+    ("band", "Band", 1),
+    ("plmn", "Plmn", 1),
+    ("tac", "Tac", 1),
+    ("cell_id", "Cell_ID", 1),
+    ("retry", "Retry", 1),
+    ("alarm", "Alarm", 1),
+    ("seq", "Seq", 1),
+)
+COLUMN_INDEX = {c[0]: i for i, c in enumerate(COLUMNS)}
+
+HEADER = struct.Struct("<qBBH")  # base, width (bytes), flags, count
+FLAG_NULLS = 1
+WIDTH_CODE = {1: "B", 2: "H", 4: "I", 8: "Q"}
+NULL_ROW = -(1 << 63)            # missing value in tail.bin
+TAIL_ROW = struct.Struct("<q%dq" % len(COLUMNS))
+
+
+def encode_block(values):
+    """Frame-of-reference block of integers (None for missing)."""
+    present = [v for v in values if v is not None]
+    nulls = len(present) != len(values)
+    base = min(present) if present else 0
+    span = max(present) - base if present else 0
+    if span == 0 and not nulls:
+        return HEADER.pack(base, 0, 0, len(values))
+    for width in (1, 2, 4, 8):
+        null_code = (1 << (8 * width)) - 1
+        if span < null_code:
+            break
+    offsets = array.array(WIDTH_CODE[width], (null_code if v is None else v - base for v in values))
+    if sys.byteorder != "little":
+        offsets.byteswap()
+    return HEADER.pack(base, width, FLAG_NULLS if nulls else 0, len(values)) + offsets.tobytes()
+
+
+def decode_block(buf, pos):
+    """(values, next position) of the block at `pos` of `buf` (bytes or mmap)."""
+    base, width, flags, count = HEADER.unpack_from(buf, pos)
+    pos += HEADER.size
+    if width == 0:
+        return [base] * count, pos
+    end = pos + count * width
+    offsets = array.array(WIDTH_CODE[width])
+    offsets.frombytes(buf[pos:end])
+    if sys.byteorder != "little":
+        offsets.byteswap()
+    if flags & FLAG_NULLS:
+        null_code = (1 << (8 * width)) - 1
+        return [None if o == null_code else base + o for o in offsets], end
+    return [base + o for o in offsets], end
+
+
+def block_spans(buf):
+    """(position, count) of every block in a segment, from the headers only."""
+    spans = []
+    pos = 0
+    size = len(buf)
+    while pos + HEADER.size <= size:
+        _, width, _, count = HEADER.unpack_from(buf, pos)
+        spans.append((pos, count))
+        pos += HEADER.size + count * width
+    return spans
+
+
+def scale_out(values, scale):
+    if scale == 1:
+        return values
+    return [None if v is None else v / scale for v in values]
+
+
+class Segment:
+    """Read-only mmap of one column segment."""
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        size = os.fstat(self.file.fileno()).st_size
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ) if size else b""
+
+    def close(self):
+        if self.map:
+            self.map.close()
+        self.file.close()
+
+
+class Store:
+    def __init__(self, root):
+        self.root = root
+        self.tails = {}  # ICCID -> [rows], rows as (ts, [values])
+        self.saved = {}  # ICCID -> rows of the tail already in tail.bin
+
+    # ---- write path
+
+    def _tail(self, iccid):
+        rows = self.tails.get(iccid)
+        if rows is None:
+            rows = []
+            path = os.path.join(self.root, iccid, "tail.bin")
+            if os.path.exists(path):
+                with open(path, "rb") as f:
+                    data = f.read()
+                for i in range(len(data) // TAIL_ROW.size):
+                    row = TAIL_ROW.unpack_from(data, i * TAIL_ROW.size)
+                    rows.append((row[0], [None if v == NULL_ROW else v for v in row[1:]]))
+            self.tails[iccid] = rows
+            self.saved[iccid] = len(rows)
+        return rows
+
+    def append(self, iccid, ts_ms, fields):
+        """Adds one row from ingest.py fields (name -> value, missing names are stored as missing)."""
+        values = []
+        for _, field, scale in COLUMNS:
+            v = fields.get(field)
+            values.append(None if v is None else round(v * scale))
+        rows = self._tail(iccid)
+        if rows and (ts_ms // DAY_MS != rows[0][0] // DAY_MS):
+            self._seal(iccid, rows)
+        rows.append((ts_ms, values))
+        if len(rows) >= BLOCK_ROWS:
+            self._seal(iccid, rows)
+
+    def _seal(self, iccid, rows):
+        """Writes the tail as one block of every column and empties it."""
+        day_dir = os.path.join(self.root, iccid, str(rows[0][0] // DAY_MS))
+        os.makedirs(day_dir, exist_ok=True)
+        with open(os.path.join(day_dir, "time.seg"), "ab") as f:
+            f.write(encode_block([r[0] for r in rows]))
+        for i, (name, _, _) in enumerate(COLUMNS):
+            with open(os.path.join(day_dir, name + ".seg"), "ab") as f:
+                f.write(encode_block([r[1][i] for r in rows]))
+        del rows[:]
+        # A crash before this truncation repeats the block's rows from tail.bin at the next start
+        path = os.path.join(self.root, iccid, "tail.bin")
+        if os.path.exists(path):
+            os.truncate(path, 0)
+        self.saved[iccid] = 0
+
+    def flush(self):
+        """Appends the rows not yet persisted to tail.bin."""
+        for iccid, rows in self.tails.items():
+            saved = self.saved[iccid]
+            if saved == len(rows):
+                continue
+            path = os.path.join(self.root, iccid, "tail.bin")
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            with open(path, "ab") as f:
+                for ts, values in rows[saved:]:
+                    f.write(TAIL_ROW.pack(ts, *(NULL_ROW if v is None else v for v in values)))
+            self.saved[iccid] = len(rows)
+
+    # ---- query path
+
+    def query(self, iccid, start_ms, end_ms, columns=None):
+        """Rows with start_ms <= time < end_ms as {"time": [...], column: [...]}."""
+        names = [c[0] for c in COLUMNS] if columns is None else list(columns)
+        index = [COLUMN_INDEX[n] for n in names]
+        result = {"time": []}
+        for name in names:
+            result[name] = []
+
+        for day in range(start_ms // DAY_MS, (end_ms - 1) // DAY_MS + 1):
+            day_dir = os.path.join(self.root, iccid, str(day))
+            if not os.path.isdir(day_dir):
+                continue
+            self._query_day(day_dir, start_ms, end_ms, names, result)
+
+        for ts, values in self._tail(iccid):
+            if start_ms <= ts < end_ms:
+                result["time"].append(ts)
+                for name, i in zip(names, index):
+                    v = values[i]
+                    result[name].append(v if v is None or COLUMNS[i][2] == 1 else v / COLUMNS[i][2])
+        return result
+
+    def _query_day(self, day_dir, start_ms, end_ms, names, result):
+        seg = Segment(os.path.join(day_dir, "time.seg"))
+        try:
+            selected = []  # (block number, from, to)
+            pos = 0
+            block = 0
+            while pos + HEADER.size <= len(seg.map):
+                times, pos = decode_block(seg.map, pos)
+                if times[-1] >= start_ms and times[0] < end_ms:
+                    lo = bisect.bisect_left(times, start_ms)
+                    hi = bisect.bisect_left(times, end_ms)
+                    selected.append((block, lo, hi))
+                    result["time"].extend(times[lo:hi])
+                block += 1
+        finally:
+            seg.close()
+        if not selected:
+            return
+
+        for name in names:
+            scale = COLUMNS[COLUMN_INDEX[name]][2]
+            out = result[name]
+            path = os.path.join(day_dir, name + ".seg")
+            if not os.path.exists(path):
+                out.extend([None] * sum(hi - lo for _, lo, hi in selected))
+                continue
+            seg = Segment(path)
+            try:
+                spans = block_spans(seg.map)
+                for block, lo, hi in selected:
+                    values, _ = decode_block(seg.map, spans[block][0])
+                    out.extend(scale_out(values[lo:hi], scale))
+            finally:
+                seg.close()
+
+
+def disk_usage(root):
+    total = 0
+    for dirpath, _, files in os.walk(root):
+        for name in files:
+            total += os.path.getsize(os.path.join(dirpath, name))
+    return total
+
+
+def bench(devices, hours, period, directory):
+    """Ingest `hours` of uplinks from `devices` gauges, then query the last 24 h of every device."""
+    root = directory or tempfile.mkdtemp(prefix="tsstore")
+    if os.path.exists(root) and os.listdir(root):
+        print("%s is not empty" % root, file=sys.stderr)
+        return 2
+    os.makedirs(root, exist_ok=True)
+    rng = random.Random(1)
+    end_ms = int(time.time() * 1000)
+    start_ms = end_ms - hours * 3600 * 1000
+    iccids = ["89810400%011d" % i for i in range(devices)]
+    rows_per_device = hours * 3600 // period
+    state = {iccid: [rng.randint(1000, 3000), rng.randint(3500, 3700), rng.uniform(5, 30)] for iccid in iccids}
+
+    store = Store(root)
+    count = 0
+    t0 = time.perf_counter()
+    for n in range(rows_per_device):
+        for i, iccid in enumerate(iccids):
+            s = state[iccid]
+            s[0] += rng.randint(-3, 3)
+            s[2] += rng.uniform(-0.05, 0.05)
+            d = [s[0] + rng.randint(-5, 5) for _ in range(5)]
+            fields = {
+                "Distance": s[0], "WaterLevel": 3000 - s[0],
+                "Distance1": d[0], "Distance2": d[1], "Distance3": d[2], "Distance4": d[3], "Distance5": d[4],
+                "BATT": s[1] - n // 500, "TEMP": round(s[2], 2),
+                "RSRP": -95 + rng.randint(-3, 3), "RSRQ": -9.5 + rng.randint(-2, 2) / 2, "SNR": 6 + rng.randint(-2, 2),
+                "ES": 7, "Band": 18, "Plmn": 44020, "Tac": 0x185C, "Cell_ID": 0x8AAA5C + i % 50,
+                "Retry": 0, "Alarm": 0, "Seq": n,
+            }
+            store.append(iccid, start_ms + n * period * 1000 + i * period * 1000 // devices, fields)
+            count += 1
+        if n % 30 == 29:
+            store.flush()
+    store.flush()
+    elapsed = time.perf_counter() - t0
+    size = disk_usage(root)
+    print("ingest: %d rows in %.2fs, %.0f rows/s, %.1f bytes/row on disk (%d columns, %.1f bytes/row as int64)"
+          % (count, elapsed, count / elapsed, size / count, len(COLUMNS) + 1, (len(COLUMNS) + 1) * 8.0))
+
+    for label, columns in (("all columns", None), ("distance", ["distance"]), ("distance,batt,temp", ["distance", "batt", "temp"])):
+        store = Store(root)  # cold: only mmap() of the segments, no cached tails
+        t0 = time.perf_counter()
+        rows = 0
+        for iccid in iccids:
+            rows += len(store.query(iccid, end_ms - 24 * 3600 * 1000, end_ms + 1, columns)["time"])
+        elapsed = time.perf_counter() - t0
+        print("query last 24 h, %d devices, %s: %d rows in %.1f ms (%.2f ms/device)"
+              % (devices, label, rows, elapsed * 1000, elapsed * 1000 / devices))
+
+    if directory is None:
+        shutil.rmtree(root)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    sub = parser.add_subparsers(dest="command", required=True)
+    q = sub.add_parser("query", help="print rows of one device as CSV")
+    q.add_argument("root")
+    q.add_argument("iccid")
+    q.add_argument("--hours", type=float, default=24)
+    q.add_argument("--columns", help="comma separated (default: all) " + ",".join(c[0] for c in COLUMNS))
+    b = sub.add_parser("bench", help="ingest rate and 24 h query latency")
+    b.add_argument("--devices", type=int, default=1000)
+    b.add_argument("--hours", type=int, default=24)
+    b.add_argument("--period", type=int, default=116)
+    b.add_argument("--dir", help="keep the store in this (empty) directory")
+    args = parser.parse_args()
+
+    if args.command == "bench":
+        return bench(args.devices, args.hours, args.period, args.dir)
+
+    columns = args.columns.split(",") if args.columns else None
+    for name in columns or ():
+        if name not in COLUMN_INDEX:
+            print("unknown column " + name, file=sys.stderr)
+            return 2
+    end_ms = int(time.time() * 1000) + 1
+    result = Store(args.root).query(args.iccid, end_ms - int(args.hours * 3600 * 1000), end_ms, columns)
+    names = list(result)
+    print(",".join(names))
+    for row in zip(*(result[n] for n in names)):
+        print(",".join("" if v is None else str(v) for v in row))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())